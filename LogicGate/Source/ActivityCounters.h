@@ -0,0 +1,63 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ACTIVITYCOUNTERS_H_8E41F0A7__
+#define __ACTIVITYCOUNTERS_H_8E41F0A7__
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief The ActivityCounters struct counts what a gate sees and does.
+ * The audio thread is the only writer, so counting is a relaxed load and
+ * store with no read-modify-write; any thread may read a snapshot.
+ */
+struct ActivityCounters
+{
+    std::atomic<uint64_t> inputEvents[2];
+    std::atomic<uint64_t> triggers;
+    std::atomic<uint64_t> expiredWindows;
+    std::atomic<uint64_t> drops;
+
+    ActivityCounters() { reset(); }
+
+    static void count (std::atomic<uint64_t>& counter)
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static uint64_t read (const std::atomic<uint64_t>& counter)
+    {
+        return counter.load (std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        inputEvents[0].store (0, std::memory_order_relaxed);
+        inputEvents[1].store (0, std::memory_order_relaxed);
+        triggers.store (0, std::memory_order_relaxed);
+        expiredWindows.store (0, std::memory_order_relaxed);
+        drops.store (0, std::memory_order_relaxed);
+    }
+};
+
+#endif  // __ACTIVITYCOUNTERS_H_8E41F0A7__
@@ -0,0 +1,62 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __COMMANDQUEUE_H_0B6E48F2__
+#define __COMMANDQUEUE_H_0B6E48F2__
+
+#include "SpscRing.h"
+
+/**
+ * @brief The GateCommand struct is one setting change of one gate, on its way
+ * from the message thread to the audio thread
+ */
+struct GateCommand
+{
+    enum Param
+    {
+        INPUT1,
+        INPUT2,
+        GATE1,
+        GATE2,
+        LOGIC_OP,
+        OUTPUT,
+        WINDOW,
+        DURATION,
+        IMMEDIATE
+    };
+
+    int gate;
+    int param;
+    int value;
+};
+
+/**
+    Wait-free ring of GateCommands: the message thread pushes, the audio
+    thread pops at the start of each buffer; neither side ever blocks.
+*/
+class CommandQueue : public SpscRing<GateCommand>
+{
+public:
+    explicit CommandQueue (int capacity = 1024) : SpscRing<GateCommand> (capacity) {}
+};
+
+#endif  // __COMMANDQUEUE_H_0B6E48F2__
@@ -0,0 +1,304 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <limits>
+
+#include "ControlServer.h"
+#include "LogicGate.h"
+#include "LogicGateEditor.h"
+
+// how long the thread blocks on a socket before checking whether it should stop
+static const int POLL_MS = 100;
+// longest command line accepted
+static const int MAX_LINE = 1024;
+
+static const char* const paramNames[] = { "input1", "input2", "gate1", "gate2", "op", "output", "window", "duration", "immediate" };
+static const char* const opNames[] = { "AND", "OR", "XOR", "DELAY" };
+
+/** Reads a string of digits, false if it is not one or does not fit an int */
+static bool parseNumber(const String& text, int& value)
+{
+    // up to 18 digits always fit an int64, longer ones would wrap while parsing
+    const String digits = text.trimCharactersAtStart("0");
+    if (text.isEmpty() || !text.containsOnly("0123456789") || digits.length() > 18)
+        return false;
+
+    const int64 number = digits.getLargeIntValue();
+    if (number > std::numeric_limits<int>::max())
+        return false;
+    value = int(number);
+    return true;
+}
+
+ControlServer::ControlServer(LogicGate& processor)
+    : Thread("Logic Gate control"),
+      m_processor(processor)
+{
+}
+
+ControlServer::~ControlServer()
+{
+    signalThreadShouldExit();
+    stopThread(2000);
+    m_listener.close();
+}
+
+bool ControlServer::start(int port)
+{
+    if (!m_listener.createListener(port, "127.0.0.1"))
+        return false;
+
+    startThread();
+    return true;
+}
+
+void ControlServer::run()
+{
+    while (!threadShouldExit())
+    {
+        if (m_listener.waitUntilReady(true, POLL_MS) <= 0)
+            continue;
+
+        ScopedPointer<StreamingSocket> client = m_listener.waitForNextConnection();
+        if (client != nullptr)
+            serve(*client);
+    }
+}
+
+void ControlServer::serve(StreamingSocket& client)
+{
+    char buffer[256];
+    String pending;
+
+    while (!threadShouldExit())
+    {
+        const int ready = client.waitUntilReady(true, POLL_MS);
+        if (ready < 0)
+            return;
+        if (ready == 0)
+            continue;
+
+        const int numBytes = client.read(buffer, sizeof(buffer), false);
+        if (numBytes <= 0)
+            return;
+        pending += String(buffer, (size_t) numBytes);
+
+        int newline;
+        while ((newline = pending.indexOfChar('\n')) >= 0)
+        {
+            const String line = pending.substring(0, newline).trim();
+            pending = pending.substring(newline + 1);
+            if (line.isEmpty())
+                continue;
+
+            String reply;
+            {
+                // gives up if the processor is being deleted
+                const MessageManagerLock lock(this);
+                if (!lock.lockWasGained())
+                    return;
+                reply = execute(line) + "\n";
+            }
+            client.write(reply.toRawUTF8(), (int) reply.getNumBytesAsUTF8());
+        }
+
+        if (pending.length() > MAX_LINE)
+            return;
+    }
+}
+
+String ControlServer::execute(const String& line)
+{
+    StringArray tokens = StringArray::fromTokens(line, true);
+    const String command = tokens[0].toLowerCase();
+
+    if (command == "gates" && tokens.size() == 1)
+        return "OK " + String(m_processor.getNumGates());
+
+    if ((command == "get" && tokens.size() == 2) || (command == "set" && tokens.size() == 3))
+    {
+        if (tokens[1].toLowerCase() == "threads")
+        {
+            if (command == "get")
+                return "OK " + String(m_processor.getNumThreads());
+            int threads;
+            if (!parseNumber(tokens[2], threads) || threads < 1)
+                return "ERR bad value " + tokens[2];
+            // the worker pool is only started or stopped with acquisition
+            m_processor.setNumThreads(threads);
+            return "OK " + String(m_processor.getNumThreads());
+        }
+        if (tokens[1].toLowerCase() != "log")
+            return "ERR unknown setting " + tokens[1];
+        if (command == "get")
+            return String("OK ") + (m_processor.getLogEnabled() ? "1" : "0");
+
+        int value;
+        if (!parseValue(GateCommand::GATE1, tokens[2], value))
+            return "ERR bad value " + tokens[2];
+        m_processor.setLogEnabled(value != 0);
+        if (LogicGateEditor* editor = (LogicGateEditor*) m_processor.getEditor())
+            editor->refreshGate();
+        return "OK";
+    }
+
+    if ((command != "get" || tokens.size() != 3) && (command != "set" || tokens.size() != 4))
+        return "ERR usage: gates | get <gate> <param> | set <gate> <param> <value>";
+
+    int gate;
+    if (!parseNumber(tokens[1], gate) || --gate < 0 || gate >= m_processor.getNumGates())
+        return "ERR no gate " + tokens[1];
+
+    int param = -1;
+    for (int i = 0; i <= GateCommand::IMMEDIATE; i++)
+        if (tokens[2].toLowerCase() == paramNames[i])
+            param = i;
+    if (param < 0)
+        return "ERR unknown setting " + tokens[2];
+
+    if (command == "get")
+    {
+        int value = 0;
+        switch (param)
+        {
+        case GateCommand::INPUT1:    value = m_processor.getInput1(gate); break;
+        case GateCommand::INPUT2:    value = m_processor.getInput2(gate); break;
+        case GateCommand::GATE1:     value = m_processor.getGate1(gate); break;
+        case GateCommand::GATE2:     value = m_processor.getGate2(gate); break;
+        case GateCommand::LOGIC_OP:  value = m_processor.getLogicOp(gate); break;
+        case GateCommand::OUTPUT:    value = m_processor.getOutput(gate); break;
+        case GateCommand::WINDOW:    value = m_processor.getWindow(gate); break;
+        case GateCommand::DURATION:  value = m_processor.getTtlDuration(gate); break;
+        case GateCommand::IMMEDIATE: value = m_processor.getImmediate(gate); break;
+        }
+        return "OK " + formatValue(param, value);
+    }
+
+    int value;
+    if (!parseValue(param, tokens[3], value))
+        return "ERR bad value " + tokens[3];
+
+    bool applied = true;
+    switch (param)
+    {
+    case GateCommand::INPUT1:
+    case GateCommand::INPUT2:
+        if (!m_processor.canUseInput(gate, param == GateCommand::INPUT1 ? 0 : 1, value))
+            return "ERR gate " + tokens[1] + " would read its own output";
+        if (param == GateCommand::INPUT1)
+            applied = m_processor.setInput1(gate, value);
+        else
+            applied = m_processor.setInput2(gate, value);
+        break;
+    case GateCommand::GATE1:     applied = m_processor.setGate1(gate, value != 0); break;
+    case GateCommand::GATE2:     applied = m_processor.setGate2(gate, value != 0); break;
+    case GateCommand::LOGIC_OP:  applied = m_processor.setLogicOp(gate, value); break;
+    case GateCommand::OUTPUT:    applied = m_processor.setOutput(gate, value); break;
+    case GateCommand::WINDOW:    applied = m_processor.setWindow(gate, value); break;
+    case GateCommand::DURATION:  applied = m_processor.setTtlDuration(gate, value); break;
+    case GateCommand::IMMEDIATE: applied = m_processor.setImmediate(gate, value != 0); break;
+    }
+    if (!applied)
+        return "ERR busy, too many changes at once";
+
+    if (LogicGateEditor* editor = (LogicGateEditor*) m_processor.getEditor())
+        editor->refreshGate();
+    return "OK";
+}
+
+bool ControlServer::parseValue(int param, const String& text, int& value)
+{
+    const String t = text.toLowerCase();
+
+    switch (param)
+    {
+    case GateCommand::INPUT1:
+    case GateCommand::INPUT2:
+        if (t == "none" || t == "0")
+        {
+            value = GateBank::NO_INPUT;
+            return true;
+        }
+        if (t.startsWith("g"))
+        {
+            int gate;
+            if (!parseNumber(t.substring(1), gate) || --gate < 0 || gate >= m_processor.getNumGates())
+                return false;
+            value = GateBank::gateInput(gate);
+            return true;
+        }
+        if (!parseNumber(t, value))
+            return false;
+        return --value < m_processor.getNumSources();
+
+    case GateCommand::GATE1:
+    case GateCommand::GATE2:
+    case GateCommand::IMMEDIATE:
+        value = (t == "1" || t == "on") ? 1 : 0;
+        return t == "1" || t == "on" || t == "0" || t == "off";
+
+    case GateCommand::LOGIC_OP:
+        for (int op = 0; op < 4; op++)
+        {
+            if (text.toUpperCase() == opNames[op])
+            {
+                value = op;
+                return true;
+            }
+        }
+        return false;
+
+    case GateCommand::OUTPUT:
+        if (t == "none")
+        {
+            value = -1;
+            return true;
+        }
+        if (!parseNumber(t, value))
+            return false;
+        return --value >= 0 && value < 8;
+
+    case GateCommand::WINDOW:
+    case GateCommand::DURATION:
+        return parseNumber(t, value);
+    }
+    return false;
+}
+
+String ControlServer::formatValue(int param, int value)
+{
+    switch (param)
+    {
+    case GateCommand::INPUT1:
+    case GateCommand::INPUT2:
+        if (GateBank::isGateInput(value))
+            return "g" + String(GateBank::inputGate(value) + 1);
+        return value < 0 ? String("none") : String(value + 1);
+
+    case GateCommand::LOGIC_OP:
+        return opNames[jlimit(0, 3, value)];
+
+    case GateCommand::OUTPUT:
+        return value < 0 ? String("none") : String(value + 1);
+    }
+    return String(value);
+}
@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __CONTROLSERVER_H_5A8C3F61__
+#define __CONTROLSERVER_H_5A8C3F61__
+
+#include <ProcessorHeaders.h>
+
+class LogicGate;
+
+/**
+    Loopback TCP endpoint to reconfigure a LogicGate from an experiment controller.
+
+    Listens on 127.0.0.1 and serves one client at a time. Each command is a text
+    line and gets a one line answer starting with OK or ERR:
+
+        gates                         number of gates
+        get <gate> <param>            gates are numbered from 1, as in the editor
+        set <gate> <param> <value>
+        get log, set log <0|1>
+        get threads, set threads <n>  from the next acquisition on
+
+    params are input1, input2, gate1, gate2, op, output, window, duration and
+    immediate. Inputs are "none", a source number as listed in the editor or
+    g<n> for the output of gate n; op is AND, OR, XOR or DELAY; output is
+    "none" or 1 to 8; windows and durations are in ms.
+
+    Commands run on the message thread (under a MessageManagerLock) through the
+    same setters as the editor, so during acquisition they reach the audio
+    thread through the processor's command queue at the next buffer boundary.
+
+    @see LogicGate, CommandQueue
+*/
+class ControlServer : public Thread
+{
+public:
+    ControlServer(LogicGate& processor);
+    ~ControlServer();
+
+    /** Starts listening on port, returns false if the port cannot be opened */
+    bool start(int port);
+
+    void run() override;
+
+    /** Runs one command line and returns the answer. Message thread only. */
+    String execute(const String& line);
+
+private:
+    void serve(StreamingSocket& client);
+    bool parseValue(int param, const String& text, int& value);
+    String formatValue(int param, int value);
+
+    LogicGate& m_processor;
+    StreamingSocket m_listener;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlServer);
+};
+
+#endif  // __CONTROLSERVER_H_5A8C3F61__
@@ -0,0 +1,157 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DecisionLog.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+static const char LOG_MAGIC[8] = { 'L', 'G', 'D', 'E', 'C', 'L', 'O', 'G' };
+
+// how often the writer wakes up to drain the ring
+static const int WRITER_PERIOD_MS = 20;
+
+DecisionLog::DecisionLog (int capacity)
+    : m_ring(capacity),
+      m_dropped(0),
+      m_file(nullptr),
+      m_stopping(false)
+{
+}
+
+DecisionLog::~DecisionLog()
+{
+    stop();
+}
+
+bool DecisionLog::start (const std::string& path, double sampleRate)
+{
+    stop();
+
+    m_file = fopen (path.c_str(), "wb");
+    if (m_file == nullptr)
+        return false;
+
+    DecisionLogHeader header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, LOG_MAGIC, sizeof (header.magic));
+    header.version = VERSION;
+    header.recordSize = sizeof (DecisionRecord);
+    header.sampleRate = sampleRate;
+    fwrite (&header, sizeof (header), 1, m_file);
+
+    m_ring.clear();
+    m_dropped.store (0, std::memory_order_relaxed);
+    m_stopping = false;
+    m_writer = std::thread (&DecisionLog::run, this);
+    return true;
+}
+
+void DecisionLog::stop()
+{
+    if (m_file == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock (m_wakeLock);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    drain();
+
+    // the header is written last so it carries the final drop count
+    const uint64_t dropped = getDroppedRecords();
+    fseek (m_file, offsetof (DecisionLogHeader, droppedRecords), SEEK_SET);
+    fwrite (&dropped, sizeof (dropped), 1, m_file);
+    fclose (m_file);
+    m_file = nullptr;
+}
+
+bool DecisionLog::append (const DecisionRecord& record)
+{
+    if (!m_ring.push (record))
+    {
+        m_dropped.store (m_dropped.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool DecisionLog::append (int64_t timestamp, DecisionRecord::Kind kind, int value, int source, int channel, int input)
+{
+    return append (makeRecord (timestamp, kind, value, source, channel, input));
+}
+
+DecisionRecord DecisionLog::makeRecord (int64_t timestamp, DecisionRecord::Kind kind, int value, int source, int channel, int input)
+{
+    DecisionRecord record;
+    record.timestamp = timestamp;
+    record.kind = uint8_t (kind);
+    record.value = uint8_t (value);
+    record.source = uint16_t (source);
+    record.channel = uint16_t (channel);
+    record.input = uint16_t (input);
+    return record;
+}
+
+void DecisionLog::run()
+{
+    std::unique_lock<std::mutex> lock (m_wakeLock);
+    while (!m_stopping)
+    {
+        m_wake.wait_for (lock, std::chrono::milliseconds (WRITER_PERIOD_MS));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+size_t DecisionLog::drain()
+{
+    return m_ring.popAll ([this] (const DecisionRecord* records, size_t count) { fwrite (records, sizeof (DecisionRecord), count, m_file); });
+}
+
+bool DecisionLog::readHeader (FILE* file, DecisionLogHeader& header)
+{
+    if (fread (&header, sizeof (header), 1, file) != 1)
+        return false;
+
+    return memcmp (header.magic, LOG_MAGIC, sizeof (header.magic)) == 0
+           && header.version == VERSION
+           && header.recordSize == sizeof (DecisionRecord);
+}
+
+const char* DecisionLog::kindName (int kind)
+{
+    switch (kind)
+    {
+    case DecisionRecord::EDGE:   return "EDGE";
+    case DecisionRecord::FIRE:   return "FIRE";
+    case DecisionRecord::RESET:  return "RESET";
+    case DecisionRecord::EXPIRE: return "EXPIRE";
+    case DecisionRecord::DROP:   return "DROP";
+    default:                     return "?";
+    }
+}
@@ -0,0 +1,132 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __DECISIONLOG_H_F27C5B19__
+#define __DECISIONLOG_H_F27C5B19__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SpscRing.h"
+
+/**
+ * @brief The DecisionRecord struct is one fixed-size entry of the decision log.
+ * Field meaning depends on kind:
+ * EDGE: value = TTL state, source = source node id, channel = TTL channel,
+ *       input = index of the source in the input lists (0xFFFF if it is not listed)
+ * FIRE, RESET, EXPIRE, DROP: value = logic operator, source = gate index,
+ *       channel = output channel, input = input that decided it (0xFFFF if none)
+ */
+struct DecisionRecord
+{
+    enum Kind
+    {
+        EDGE = 1,
+        FIRE = 2,
+        RESET = 3,
+        EXPIRE = 4,
+        DROP = 5
+    };
+
+    int64_t timestamp;
+    uint8_t kind;
+    uint8_t value;
+    uint16_t source;
+    uint16_t channel;
+    uint16_t input;
+};
+
+static_assert (sizeof (DecisionRecord) == 16, "DecisionRecord must stay 16 bytes");
+
+/**
+ * @brief The DecisionLogHeader struct starts every log file, records follow back to back.
+ * droppedRecords is filled in when the log is closed.
+ */
+struct DecisionLogHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    double sampleRate;
+    uint64_t droppedRecords;
+};
+
+static_assert (sizeof (DecisionLogHeader) == 32, "DecisionLogHeader must stay 32 bytes");
+
+/**
+    Binary log of every edge and decision of the processor.
+
+    The audio thread appends records to a preallocated single-producer ring and
+    never waits: when the ring is full the record is dropped and counted. A
+    background thread drains the ring and appends it to the file.
+*/
+class DecisionLog
+{
+public:
+    explicit DecisionLog (int capacity = 1 << 16);
+    ~DecisionLog();
+
+    /** Opens path and starts the writer thread. Message thread only. */
+    bool start (const std::string& path, double sampleRate);
+    /** Flushes every pending record, stops the writer and closes the file. Message thread only. */
+    void stop();
+    bool isRunning() const { return m_file != nullptr; }
+
+    /** Audio thread only. Returns false if the record had to be dropped. */
+    bool append (const DecisionRecord& record);
+    bool append (int64_t timestamp, DecisionRecord::Kind kind, int value, int source, int channel, int input);
+
+    static DecisionRecord makeRecord (int64_t timestamp, DecisionRecord::Kind kind, int value, int source, int channel, int input);
+
+    uint64_t getDroppedRecords() const { return m_dropped.load (std::memory_order_relaxed); }
+
+    /** Reads and checks the header of a log file, leaves file positioned at the first record. */
+    static bool readHeader (FILE* file, DecisionLogHeader& header);
+
+    static const char* kindName (int kind);
+
+    static const uint32_t VERSION = 1;
+
+private:
+    void run();
+    /** Writes out everything published so far, returns the number of records written. */
+    size_t drain();
+
+    SpscRing<DecisionRecord> m_ring;
+    std::atomic<uint64_t> m_dropped;
+
+    FILE* m_file;
+    std::thread m_writer;
+    std::mutex m_wakeLock;
+    std::condition_variable m_wake;
+    bool m_stopping;
+
+    DecisionLog (const DecisionLog&) = delete;
+    DecisionLog& operator= (const DecisionLog&) = delete;
+};
+
+#endif  // __DECISIONLOG_H_F27C5B19__
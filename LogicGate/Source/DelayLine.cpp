@@ -0,0 +1,61 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DelayLine.h"
+
+DelayLine::DelayLine (int capacity)
+    : m_edges(capacity),
+      m_overflows(0),
+      m_highWater(0)
+{
+}
+
+bool DelayLine::push (int64_t timestamp)
+{
+    if (!m_edges.push (timestamp))
+    {
+        m_overflows.store (m_overflows.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const int pending = getNumPending();
+    if (pending > m_highWater.load (std::memory_order_relaxed))
+        m_highWater.store (pending, std::memory_order_relaxed);
+    return true;
+}
+
+void DelayLine::pop()
+{
+    int64_t timestamp;
+    m_edges.pop (timestamp);
+}
+
+void DelayLine::clear()
+{
+    m_edges.clear();
+}
+
+void DelayLine::resetCounters()
+{
+    m_overflows.store (0, std::memory_order_relaxed);
+    m_highWater.store (0, std::memory_order_relaxed);
+}
@@ -0,0 +1,69 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __DELAYLINE_H_5D92B0E4__
+#define __DELAYLINE_H_5D92B0E4__
+
+#include <atomic>
+#include <cstdint>
+
+#include "SpscRing.h"
+
+/**
+    Bounded FIFO of pending edge timestamps used by the DELAY operator.
+
+    The audio thread both pushes and pops, on a preallocated SpscRing. Edges
+    that find the ring full are dropped and counted; the counters can be
+    read from any thread.
+*/
+class DelayLine
+{
+public:
+    explicit DelayLine (int capacity = 1024);
+
+    /** Queues an edge, returns false (and counts an overflow) if the ring is full. */
+    bool push (int64_t timestamp);
+    /** Oldest pending edge, only valid when not empty. */
+    int64_t front() const { return m_edges.front(); }
+    void pop();
+    /** Drops every pending edge, the counters are kept. */
+    void clear();
+
+    bool isEmpty() const { return m_edges.isEmpty(); }
+    int getNumPending() const { return m_edges.getNumPending(); }
+    int getCapacity() const { return m_edges.getCapacity(); }
+
+    uint64_t getOverflowCount() const { return m_overflows.load (std::memory_order_relaxed); }
+    int getHighWaterMark() const { return m_highWater.load (std::memory_order_relaxed); }
+    void resetCounters();
+
+private:
+    SpscRing<int64_t> m_edges;
+
+    std::atomic<uint64_t> m_overflows;
+    std::atomic<int> m_highWater;
+
+    DelayLine (const DelayLine&) = delete;
+    DelayLine& operator= (const DelayLine&) = delete;
+};
+
+#endif  // __DELAYLINE_H_5D92B0E4__
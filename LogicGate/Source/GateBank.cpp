@@ -0,0 +1,542 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "GateBank.h"
+#include "GateWorkerPool.h"
+
+GateBank::Node::Node (GateBank& owner, int i)
+    : bank(owner),
+      index(i),
+      engine(*this),
+      merged(0),
+      cause(-1)
+{
+    pending.reserve (PENDING_EDGES);
+    outputs.reserve (HELD_OUTPUTS);
+    decisions.reserve (HELD_DECISIONS);
+    wake.owner = i;
+}
+
+void GateBank::Node::gateOutput (int64_t timestamp, bool on, int outputChan)
+{
+    if (outputChan >= 0)
+    {
+        if (bank.m_pool != nullptr)
+        {
+            // held back until every group is done, then merged
+            Output output = { timestamp, on, outputChan };
+            outputs.push_back (output);
+        }
+        else
+        {
+            bank.m_listener.gateOutput (timestamp, on, outputChan);
+        }
+    }
+
+    if (on)
+    {
+        for (int consumer : bank.m_wiring->consumers[index])
+        {
+            PendingEdge edge = { timestamp, consumer & 1, cause };
+            bank.m_nodes[consumer >> 1]->pending.push_back (edge);
+            bank.markDirty (consumer >> 1);
+        }
+    }
+}
+
+GateBank::GateBank (GateEngine::Listener& listener)
+    : m_listener(listener),
+      m_wiring(new Wiring()),
+      m_until(0),
+      m_sequence(0),
+      m_log(nullptr),
+      m_now(0)
+{
+}
+
+GateBank::~GateBank()
+{
+}
+
+bool GateBank::sortGates (const std::vector<Gate>& gates, std::vector<int>& order)
+{
+    const int n = int (gates.size());
+    order.clear();
+
+    // Kahn: repeatedly take the lowest gate whose upstream gates are all placed
+    std::vector<bool> placed (n, false);
+    while (int (order.size()) < n)
+    {
+        int next = -1;
+        for (int g = 0; g < n && next < 0; g++)
+        {
+            if (placed[g])
+                continue;
+
+            bool ready = true;
+            for (int i = 0; i < 2; i++)
+            {
+                const int input = gates[g].inputs[i];
+                if (!isGateInput (input))
+                    continue;
+                const int upstream = inputGate (input);
+                if (upstream >= n)
+                    return false;
+                if (!placed[upstream])
+                    ready = false;
+            }
+            if (ready)
+                next = g;
+        }
+
+        if (next < 0)
+            return false;
+        placed[next] = true;
+        order.push_back (next);
+    }
+    return true;
+}
+
+std::unique_ptr<GateBank::Wiring> GateBank::makeWiring (const std::vector<Gate>& gates, bool grouped)
+{
+    std::unique_ptr<Wiring> wiring (new Wiring());
+    if (!sortGates (gates, wiring->order))
+        return nullptr;
+
+    const int n = int (gates.size());
+    wiring->grouped = grouped;
+    wiring->inputs.resize (n * 2);
+    wiring->consumers.resize (n);
+    for (int g = 0; g < n; g++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            const int input = gates[g].inputs[i];
+            wiring->inputs[g * 2 + i] = input;
+            if (isGateInput (input))
+            {
+                wiring->consumers[inputGate (input)].push_back (g * 2 + i);
+            }
+            else if (input != NO_INPUT)
+            {
+                Reader r = { input, g, i };
+                wiring->readers.push_back (r);
+            }
+        }
+    }
+    std::stable_sort (wiring->readers.begin(), wiring->readers.end(),
+                      [] (const Reader& a, const Reader& b) { return a.line < b.line; });
+
+    wiring->groupOf.assign (n, 0);
+    if (!grouped)
+    {
+        // a single group in topological order
+        wiring->slots = wiring->order;
+        wiring->groupFirstWord.push_back (0);
+        wiring->groupEndWord.push_back ((n + 63) / 64);
+        wiring->groupFirstGate.push_back (0);
+    }
+    else
+    {
+        // connected components of the gate-to-gate wiring, external lines do not join gates
+        std::vector<int> root (n);
+        for (int g = 0; g < n; g++)
+            root[g] = g;
+        auto find = [&root] (int g)
+        {
+            while (root[g] != g)
+                g = root[g] = root[root[g]];
+            return g;
+        };
+        for (int g = 0; g < n; g++)
+            for (int consumer : wiring->consumers[g])
+                root[find (consumer >> 1)] = find (g);
+
+        // groups numbered by their first gate in topological order, each keeps that order
+        std::vector<int> groupOfRoot (n, -1);
+        std::vector<std::vector<int>> members;
+        for (int g : wiring->order)
+        {
+            int& group = groupOfRoot[find (g)];
+            if (group < 0)
+            {
+                group = int (members.size());
+                members.emplace_back();
+            }
+            members[group].push_back (g);
+            wiring->groupOf[g] = group;
+        }
+
+        // every group starts on a word of its own so workers never share one
+        for (size_t group = 0; group < members.size(); group++)
+        {
+            wiring->groupFirstWord.push_back (int (wiring->slots.size() / 64));
+            wiring->groupFirstGate.push_back (group == 0 ? 0 : wiring->groupFirstGate.back() + int (members[group - 1].size()));
+            wiring->slots.insert (wiring->slots.end(), members[group].begin(), members[group].end());
+            wiring->slots.resize ((wiring->slots.size() + 63) / 64 * 64, -1);
+            wiring->groupEndWord.push_back (int (wiring->slots.size() / 64));
+        }
+    }
+
+    wiring->rank.assign (n, 0);
+    for (int slot = 0; slot < int (wiring->slots.size()); slot++)
+        if (wiring->slots[slot] >= 0)
+            wiring->rank[wiring->slots[slot]] = slot;
+    return wiring;
+}
+
+bool GateBank::setGates (const std::vector<Gate>& gates)
+{
+    // a rejected wiring leaves the current one in place
+    std::unique_ptr<Wiring> wiring = makeWiring (gates, isParallel());
+    if (wiring == nullptr)
+        return false;
+
+    const int n = int (gates.size());
+    for (int g = n; g < int (m_nodes.size()); g++)
+        m_wakeups.cancel (m_nodes[g]->wake);
+    m_nodes.resize (std::min (int (m_nodes.size()), n));
+    while (int (m_nodes.size()) < n)
+    {
+        m_nodes.emplace_back (new Node (*this, int (m_nodes.size())));
+        m_nodes.back()->engine.reset (m_now);
+    }
+
+    m_wiring.swap (wiring);
+    prepareBuffers();
+
+    for (int g = 0; g < n; g++)
+        setConfig (g, gates[g].config);
+
+    applyLog();
+    return true;
+}
+
+bool GateBank::swapWiring (std::unique_ptr<Wiring>& wiring)
+{
+    if (wiring == nullptr || wiring->getNumGates() != getNumGates() || wiring->grouped != isParallel())
+        return false;
+
+    // dirty bits are ranks of the old layout: collect their gates, then mark them again
+    m_merge.clear();
+    const std::vector<int>& oldSlots = m_wiring->slots;
+    for (int w = 0; w < m_wiring->getNumWords(); w++)
+    {
+        for (uint64_t bits = m_dirty[w]; bits != 0; bits &= bits - 1)
+        {
+            int bit = 0;
+            while (((bits >> bit) & 1) == 0)
+                ++bit;
+            m_merge.push_back (oldSlots[(w << 6) + bit]);
+        }
+        m_dirty[w] = 0;
+    }
+
+    m_wiring.swap (wiring);
+    for (int gate : m_merge)
+        markDirty (gate);
+    m_merge.clear();
+    return true;
+}
+
+void GateBank::setConfig (int gate, const GateConfig& config)
+{
+    // idle gates lag behind, bring them to the bank's time before reconfiguring
+    Node& node = *m_nodes[gate];
+    node.engine.advanceTo (m_now);
+    node.engine.setConfig (config);
+    scheduleWake (node);
+
+    // with worker threads what that produced is held back, the next advanceTo() merges it
+    if (!node.outputs.empty() || !node.decisions.empty())
+        markDirty (gate);
+}
+
+void GateBank::prepareBuffers()
+{
+    // any layout fits: at most one group per gate, each padded to a whole word
+    const int n = getNumGates();
+    m_dirty.assign (n + n / 64 + 1, 0);
+    m_settled.assign (n, 0);
+    m_numSettled.assign (n, 0);
+    m_merge.clear();
+    m_merge.reserve (n);
+}
+
+void GateBank::setNumThreads (int numThreads)
+{
+    if (numThreads == getNumThreads())
+        return;
+
+    m_pool.reset (numThreads > 1 ? new GateWorkerPool (numThreads - 1) : nullptr);
+
+    // lay the same connections out again for the new mode
+    std::vector<Gate> gates (getNumGates());
+    for (int g = 0; g < getNumGates(); g++)
+        for (int i = 0; i < 2; i++)
+            gates[g].inputs[i] = m_wiring->inputs[g * 2 + i];
+    m_wiring = makeWiring (gates, isParallel());
+    prepareBuffers();
+    applyLog();
+}
+
+int GateBank::getNumThreads() const
+{
+    return m_pool != nullptr ? m_pool->getNumWorkers() + 1 : 1;
+}
+
+void GateBank::setLog (DecisionLog* log)
+{
+    m_log = log;
+    applyLog();
+}
+
+void GateBank::applyLog()
+{
+    // worker threads hold their decisions back, the log is only written from the calling thread
+    for (auto& node : m_nodes)
+    {
+        if (m_pool != nullptr)
+            node->engine.setLogRecords (m_log != nullptr ? &node->decisions : nullptr, node->index);
+        else
+            node->engine.setLog (m_log, node->index);
+    }
+}
+
+void GateBank::reset (int64_t now)
+{
+    m_now = now;
+    m_wakeups.reset (now);
+    m_sequence = 0;
+    std::fill (m_dirty.begin(), m_dirty.end(), 0);
+    std::fill (m_numSettled.begin(), m_numSettled.end(), 0);
+    for (auto& node : m_nodes)
+    {
+        node->engine.reset (now);
+        node->pending.clear();
+        node->outputs.clear();
+        node->decisions.clear();
+        node->merged = 0;
+    }
+}
+
+void GateBank::resetCounters()
+{
+    for (auto& node : m_nodes)
+        node->engine.resetCounters();
+}
+
+void GateBank::advanceTo (int64_t until)
+{
+    if (m_pool != nullptr)
+        settleParallel (until);
+    else
+        settle (until);
+}
+
+void GateBank::inputEdge (int line, int64_t timestamp)
+{
+    const std::vector<Reader>& readers = m_wiring->readers;
+    Reader key = { line, 0, 0 };
+    auto range = std::equal_range (readers.begin(), readers.end(), key,
+                                   [] (const Reader& a, const Reader& b) { return a.line < b.line; });
+    for (auto r = range.first; r != range.second; ++r)
+    {
+        PendingEdge edge = { timestamp, r->input, m_sequence };
+        m_nodes[r->gate]->pending.push_back (edge);
+        markDirty (r->gate);
+    }
+    ++m_sequence;
+
+    if (m_pool == nullptr)
+        settle (timestamp + 1);
+}
+
+void GateBank::markDirty (int gate)
+{
+    const int rank = m_wiring->rank[gate];
+    m_dirty[rank >> 6] |= uint64_t (1) << (rank & 63);
+}
+
+void GateBank::settle (int64_t until)
+{
+    m_wakeups.advance (until, [this] (TimerNode& wake) { markDirty (wake.owner); });
+
+    // settling a gate can only dirty gates of a higher rank, so one forward pass is enough
+    const int numWords = m_wiring->getNumWords();
+    for (int w = 0; w < numWords; w++)
+    {
+        while (m_dirty[w] != 0)
+        {
+            const uint64_t bits = m_dirty[w];
+            int bit = 0;
+            while (((bits >> bit) & 1) == 0)
+                ++bit;
+            m_dirty[w] = bits & (bits - 1);
+
+            Node& node = *m_nodes[m_wiring->slots[(w << 6) + bit]];
+            settleGate (node, until);
+            scheduleWake (node);
+        }
+    }
+
+    m_sequence = 0;
+    if (until > m_now)
+        m_now = until;
+}
+
+template <typename Item, typename Emit>
+void GateBank::mergeHeld (std::vector<Item> Node::* held, Emit&& emit)
+{
+    m_merge.clear();
+    for (int g = 0; g < getNumGroups(); g++)
+    {
+        for (int i = 0; i < m_numSettled[g]; i++)
+        {
+            const int gate = m_settled[m_wiring->groupFirstGate[g] + i];
+            if (!((*m_nodes[gate]).*held).empty())
+                m_merge.push_back (gate);
+        }
+    }
+
+    // each gate's items are in timestamp order already
+    auto later = [this, held] (int a, int b)
+    {
+        const Node& x = *m_nodes[a];
+        const Node& y = *m_nodes[b];
+        const int64_t tx = (x.*held)[x.merged].timestamp;
+        const int64_t ty = (y.*held)[y.merged].timestamp;
+        return tx != ty ? tx > ty : a > b;
+    };
+    std::make_heap (m_merge.begin(), m_merge.end(), later);
+    while (!m_merge.empty())
+    {
+        std::pop_heap (m_merge.begin(), m_merge.end(), later);
+        Node& node = *m_nodes[m_merge.back()];
+        std::vector<Item>& items = node.*held;
+        emit (items[node.merged++]);
+
+        if (node.merged < items.size())
+        {
+            std::push_heap (m_merge.begin(), m_merge.end(), later);
+        }
+        else
+        {
+            items.clear();
+            node.merged = 0;
+            m_merge.pop_back();
+        }
+    }
+}
+
+void GateBank::settleParallel (int64_t until)
+{
+    m_wakeups.advance (until, [this] (TimerNode& wake) { markDirty (wake.owner); });
+
+    const int numGroups = getNumGroups();
+    m_until = until;
+    m_pool->run (numGroups, &GateBank::settleGroup, this);
+
+    // the wheel, the listener and the log are only touched from this thread
+    for (int g = 0; g < numGroups; g++)
+        for (int i = 0; i < m_numSettled[g]; i++)
+            scheduleWake (*m_nodes[m_settled[m_wiring->groupFirstGate[g] + i]]);
+
+    mergeHeld (&Node::outputs, [this] (const Output& output)
+    {
+        m_listener.gateOutput (output.timestamp, output.on, output.outputChan);
+    });
+    if (m_log != nullptr)
+        mergeHeld (&Node::decisions, [this] (const DecisionRecord& record) { m_log->append (record); });
+
+    std::fill (m_numSettled.begin(), m_numSettled.begin() + numGroups, 0);
+    m_sequence = 0;
+    if (until > m_now)
+        m_now = until;
+}
+
+void GateBank::settleGroup (void* context, int index)
+{
+    GateBank& bank = *static_cast<GateBank*> (context);
+    const Wiring& wiring = *bank.m_wiring;
+    int* settled = &bank.m_settled[wiring.groupFirstGate[index]];
+    int& numSettled = bank.m_numSettled[index];
+
+    for (int w = wiring.groupFirstWord[index]; w < wiring.groupEndWord[index]; w++)
+    {
+        while (bank.m_dirty[w] != 0)
+        {
+            const uint64_t bits = bank.m_dirty[w];
+            int bit = 0;
+            while (((bits >> bit) & 1) == 0)
+                ++bit;
+            bank.m_dirty[w] = bits & (bits - 1);
+
+            Node& node = *bank.m_nodes[wiring.slots[(w << 6) + bit]];
+            bank.settleGate (node, bank.m_until);
+            settled[numSettled++] = node.index;
+        }
+    }
+}
+
+void GateBank::settleGate (Node& node, int64_t until)
+{
+    if (!node.pending.empty())
+    {
+        // edges of different upstream gates interleave in time; within a sample,
+        // edges caused by deadlines come first, then those of each TTL edge in turn.
+        // They arrive nearly sorted, an insertion sort keeps ties in order without allocating
+        std::vector<PendingEdge>& pending = node.pending;
+        for (size_t i = 1; i < pending.size(); i++)
+        {
+            const PendingEdge edge = pending[i];
+            size_t j = i;
+            for (; j > 0 && (pending[j - 1].timestamp > edge.timestamp
+                             || (pending[j - 1].timestamp == edge.timestamp && pending[j - 1].sequence > edge.sequence)); j--)
+                pending[j] = pending[j - 1];
+            pending[j] = edge;
+        }
+
+        for (const PendingEdge& edge : node.pending)
+        {
+            node.cause = -1;
+            node.engine.advanceTo (edge.timestamp + 1);
+            node.cause = edge.sequence;
+            node.engine.inputEdge (edge.input, edge.timestamp);
+        }
+        node.pending.clear();
+    }
+
+    node.cause = -1;
+    node.engine.advanceTo (until);
+}
+
+void GateBank::scheduleWake (Node& node)
+{
+    const int64_t next = node.engine.getNextDeadline();
+    if (next == INT64_MAX)
+        m_wakeups.cancel (node.wake);
+    else
+        m_wakeups.schedule (node.wake, next);
+}
@@ -0,0 +1,281 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __GATEBANK_H_C7A3E915__
+#define __GATEBANK_H_C7A3E915__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GateEngine.h"
+
+class GateWorkerPool;
+
+/**
+    A set of gates wired into a directed acyclic graph.
+
+    Each gate input reads either an external TTL line or the output of another
+    gate. Rising output edges go straight into the inputs that read them, with
+    their sample timestamp, so a multi-stage decision (e.g. A AND B followed by
+    DELAY) is taken within the buffer the first edge arrived in, without
+    sending a TTL event down the signal chain.
+
+    Gates are evaluated in topological order: when a gate's turn comes, every
+    gate it reads from has already been settled up to the same time, and the
+    edges they produced are applied in timestamp order before the gate's own
+    deadlines are fired. Within one sample, a gate's deadlines are settled
+    before its input edges, as in a single GateEngine.
+
+    Only gates with something to do are visited: new input edges mark a gate
+    dirty, and each gate's next deadline waits in a bank-level TimingWheel that
+    marks it dirty when the deadline falls inside the interval being settled.
+    Dirty gates live in a bitset indexed by topological rank, so walking it in
+    bit order is the evaluation order, and an idle gate costs nothing. A gate's
+    own clock only catches up with the bank when it is visited.
+
+    Everything that depends on how the gates are connected lives in a Wiring,
+    built with makeWiring() where allocating is fine. During acquisition the
+    audio thread only calls setConfig() and swapWiring(), neither allocates.
+
+    Outputs reach the Listener grouped by gate, each gate in timestamp order.
+
+    With more than one thread (setNumThreads), gates are split into groups that
+    share no gate-to-gate connection, each group laid out on its own words of
+    the dirty bitset. inputEdge() then only queues the edge, and advanceTo()
+    settles every group once, on a GateWorkerPool; the outputs are handed to
+    the Listener afterwards from the calling thread, merged in (timestamp,
+    gate) order. Every edge carries the sequence number of the TTL edge that
+    caused it, so edges falling on the same sample reach a gate in the same
+    order either way and the decisions are identical. The DecisionLog takes a
+    single writer: each gate holds its decisions back like its outputs, and
+    they are appended in (timestamp, gate) order by the calling thread.
+
+    @see GateEngine, LogicGate
+*/
+class GateBank
+{
+public:
+    /** A gate and where its inputs A and B come from (see the input helpers below). */
+    struct Gate
+    {
+        GateConfig config;
+        int inputs[2] = { NO_INPUT, NO_INPUT };
+    };
+
+    /** Input not connected. */
+    static const int NO_INPUT = -1;
+    /** Inputs >= 0 are external lines, negative ones below NO_INPUT are gate outputs. */
+    static int gateInput (int gate) { return -2 - gate; }
+    static bool isGateInput (int input) { return input <= -2; }
+    static int inputGate (int input) { return -2 - input; }
+
+    struct Reader
+    {
+        int line;
+        int gate;
+        int input;
+    };
+
+    /** How the gates are connected and in which order they are settled. */
+    struct Wiring
+    {
+        /** Inputs A and B of each gate, two per gate */
+        std::vector<int> inputs;
+        /** Gates in topological order */
+        std::vector<int> order;
+        /** Gate at each bit of the dirty bitset in evaluation order, -1 for the padding between groups */
+        std::vector<int> slots;
+        /** Bit of each gate in the dirty bitset */
+        std::vector<int> rank;
+        /** Group of each gate */
+        std::vector<int> groupOf;
+        /** Words [firstWord, endWord) of the dirty bitset each group covers */
+        std::vector<int> groupFirstWord;
+        std::vector<int> groupEndWord;
+        /** Number of gates in the groups before each one */
+        std::vector<int> groupFirstGate;
+        /** (gate, input) pairs reading each gate's output, as gate * 2 + input */
+        std::vector<std::vector<int>> consumers;
+        /** Gate inputs reading external lines, sorted by line */
+        std::vector<Reader> readers;
+        /** Laid out by group, for worker threads */
+        bool grouped = false;
+
+        int getNumGates() const { return int (rank.size()); }
+        int getNumWords() const { return int (slots.size() + 63) / 64; }
+    };
+
+    explicit GateBank (GateEngine::Listener& listener);
+    ~GateBank();
+
+    /**
+     * @brief setGates resizes and rewires the bank. Gates that already existed
+     * keep their state, as with GateEngine::setConfig. Allocates: during
+     * acquisition use setConfig() and swapWiring() instead.
+     * @return false, leaving the bank unchanged, if the gates do not form a DAG
+     * or read a gate that does not exist
+     */
+    bool setGates (const std::vector<Gate>& gates);
+
+    /**
+     * @brief makeWiring works out the connections of gates, laid out by group for
+     * a bank with worker threads (see isParallel())
+     * @return nullptr if the gates do not form a DAG or read a gate that does not exist
+     */
+    static std::unique_ptr<Wiring> makeWiring (const std::vector<Gate>& gates, bool grouped);
+
+    /**
+     * @brief swapWiring installs wiring and hands back the previous one in it,
+     * without allocating. Between two advanceTo() calls only; gates waiting to be
+     * settled stay marked under the new layout.
+     * @return false, leaving both unchanged, if wiring is for another number
+     * of gates or another layout
+     */
+    bool swapWiring (std::unique_ptr<Wiring>& wiring);
+
+    /** Applies new settings to one gate, without allocating. */
+    void setConfig (int gate, const GateConfig& config);
+
+    /**
+     * @brief sortGates puts gate indices in an order where every gate comes after
+     * the gates it reads from; ties keep index order
+     * @return false if the gates contain a cycle or read a gate that does not exist
+     */
+    static bool sortGates (const std::vector<Gate>& gates, std::vector<int>& order);
+
+    int getNumGates() const { return int (m_nodes.size()); }
+    const GateEngine& getGate (int gate) const { return m_nodes[gate]->engine; }
+
+    /** Log to write decisions to, each gate logs its index as the source. */
+    void setLog (DecisionLog* log);
+
+    /**
+     * @brief setNumThreads starts or stops the worker pool; 1 or less settles
+     * every gate on the calling thread. Allocates, not while edges are queued.
+     */
+    void setNumThreads (int numThreads);
+    int getNumThreads() const;
+    bool isParallel() const { return m_pool != nullptr; }
+    /** Groups of gates that can be settled independently */
+    int getNumGroups() const { return int (m_wiring->groupFirstWord.size()); }
+
+    /** Forgets all state and restarts the clock at now. */
+    void reset (int64_t now);
+    int64_t getNow() const { return m_now; }
+
+    /** Fires every deadline earlier than until, in every gate. */
+    void advanceTo (int64_t until);
+
+    /**
+     * @brief inputEdge applies a rising edge of an external line to every gate
+     * input that reads it. With worker threads the edge waits for the next
+     * advanceTo(), edges must then arrive in timestamp order.
+     */
+    void inputEdge (int line, int64_t timestamp);
+
+    void resetCounters();
+
+private:
+    struct PendingEdge
+    {
+        int64_t timestamp;
+        int input;
+        /** Order of the causing TTL edge among those queued, -1 for a deadline */
+        int sequence;
+    };
+
+    struct Output
+    {
+        int64_t timestamp;
+        bool on;
+        int outputChan;
+    };
+
+    /**
+     * Room reserved per gate for the edges queued and the outputs held back in one
+     * advanceTo(), so a settle does not allocate; a busier gate grows them once
+     */
+    static const int PENDING_EDGES = 128;
+    static const int HELD_OUTPUTS = 128;
+    static const int HELD_DECISIONS = 128;
+
+    /** One gate, it receives the output of its own engine. */
+    struct Node : public GateEngine::Listener
+    {
+        Node (GateBank& owner, int index);
+        void gateOutput (int64_t timestamp, bool on, int outputChan) override;
+
+        GateBank& bank;
+        int index;
+        GateEngine engine;
+        /** Edges from upstream gates and external lines not applied yet */
+        std::vector<PendingEdge> pending;
+        /** With worker threads, outputs and decisions held back for the merge, in timestamp order */
+        std::vector<Output> outputs;
+        std::vector<DecisionRecord> decisions;
+        /** Next held item to merge */
+        size_t merged;
+        /** Scheduled in the bank's wakeup wheel at the engine's next deadline */
+        TimerNode wake;
+        /** Sequence given to the edges the engine is producing */
+        int cause;
+    };
+
+    void settle (int64_t until);
+    void settleParallel (int64_t until);
+    static void settleGroup (void* context, int index);
+    void settleGate (Node& node, int64_t until);
+    /** Hands the items held by the settled gates to emit in (timestamp, gate) order and empties them */
+    template <typename Item, typename Emit>
+    void mergeHeld (std::vector<Item> Node::* held, Emit&& emit);
+    void scheduleWake (Node& node);
+    void markDirty (int gate);
+    /** Sizes the per-buffer state for any wiring of the current number of gates */
+    void prepareBuffers();
+    void applyLog();
+
+    GateEngine::Listener& m_listener;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::unique_ptr<Wiring> m_wiring;
+    /** Gates that have to be settled, one bit per slot of the wiring */
+    std::vector<uint64_t> m_dirty;
+    /** Gates settled by each worker task, group g's from its groupFirstGate on */
+    std::vector<int> m_settled;
+    /** Gates settled so far in each group, as many groups as gates at most */
+    std::vector<int> m_numSettled;
+    /** Gates with outputs left to merge, as a heap on their next output; swapWiring() lists dirty gates in it */
+    std::vector<int> m_merge;
+    std::unique_ptr<GateWorkerPool> m_pool;
+    int64_t m_until;
+    /** TTL edges queued since the last settle */
+    int m_sequence;
+    /** Declared after m_nodes so it goes first, before the nodes it links */
+    TimingWheel m_wakeups;
+    DecisionLog* m_log;
+    int64_t m_now;
+
+    GateBank (const GateBank&) = delete;
+    GateBank& operator= (const GateBank&) = delete;
+};
+
+#endif  // __GATEBANK_H_C7A3E915__
@@ -0,0 +1,309 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+
+#include "GateEngine.h"
+
+GateEngine::GateEngine (Listener& listener)
+    : m_listener(listener),
+      m_log(nullptr),
+      m_records(nullptr),
+      m_logSource(0),
+      m_windowOpen(false),
+      m_windowStart(0),
+      m_windowFirstInput(-1),
+      m_windowFired(false),
+      A(false),
+      B(false)
+{
+    m_offTimer.kind = PULSE_OFF;
+    m_delayTimer.kind = DELAY_DUE;
+}
+
+int64_t GateEngine::msToSamples (int ms, float sampleRate)
+{
+    return static_cast<int64_t> (std::ceil (ms / 1000.0f * sampleRate));
+}
+
+void GateEngine::setConfig (const GateConfig& config)
+{
+    const bool restart = config.logicOp != m_config.logicOp || config.immediate != m_config.immediate;
+
+    // a pulse still high ends on the line it started on
+    if (config.outputChan != m_config.outputChan && m_offTimer.isScheduled())
+    {
+        m_timers.cancel (m_offTimer);
+        m_listener.gateOutput (m_timers.getNow(), false, m_offTimer.owner);
+    }
+
+    m_config = config;
+
+    if (restart)
+    {
+        logDecision (m_timers.getNow(), DecisionRecord::RESET, -1);
+        closeWindow();
+        resetDelay();
+    }
+}
+
+void GateEngine::reset (int64_t now)
+{
+    m_timers.reset (now);
+    m_delayLine.clear();
+    m_windowOpen = false;
+    A = false;
+    B = false;
+}
+
+void GateEngine::resetCounters()
+{
+    m_activity.reset();
+    m_delayLine.resetCounters();
+}
+
+void GateEngine::advanceTo (int64_t until)
+{
+    m_timers.advance (until, [this] (TimerNode& timer) { handleTimer (timer); });
+}
+
+int64_t GateEngine::getNextDeadline() const
+{
+    int64_t next = INT64_MAX;
+    const TimerNode* timers[] = { &m_windowTimer, &m_offTimer, &m_delayTimer };
+    for (const TimerNode* timer : timers)
+        if (timer->isScheduled() && timer->when < next)
+            next = timer->when;
+    return next;
+}
+
+void GateEngine::inputEdge (int input, int64_t timestamp)
+{
+    // deadlines up to and including this sample are settled before the edge
+    advanceTo (timestamp + 1);
+
+    ActivityCounters::count (m_activity.inputEvents[input]);
+    bool& condition = (input == 0) ? A : B;
+
+    switch (m_config.logicOp)
+    {
+    case LOGIC_AND:
+        //AND: as soon as AND is true send TTL output. Gated inputs (or both, if none is gated)
+        //(re)open the window, the other input only counts inside it
+        if ((input == 0 ? m_config.gate1 : m_config.gate2) || (!m_config.gate1 && !m_config.gate2))
+            openWindow (input, timestamp, WINDOW_END);
+        else if (!m_windowOpen)
+            break;
+
+        condition = true;
+        if (A && B)
+        {
+            triggerEvent (timestamp, input);
+            m_windowFired = true;
+
+            if ((m_config.gate1 == m_config.gate2))
+            {
+                A = false;
+                B = false;
+            }
+            else if (!m_config.gate1)
+            {
+                A = false;
+            }
+            else if (!m_config.gate2)
+            {
+                B = false;
+            }
+        }
+        break;
+
+    case LOGIC_OR:
+        //OR: the first edge opens the window. The TTL is sent at the end of the window, or
+        //right away in immediate mode, where the rest of the window is refractory
+        if (!m_windowOpen)
+        {
+            if (m_config.immediate)
+            {
+                triggerEvent (timestamp, input);
+                openWindow (input, timestamp, REFRACTORY_END);
+            }
+            else
+            {
+                condition = true;
+                openWindow (input, timestamp, WINDOW_END);
+            }
+        }
+        else
+        {
+            ActivityCounters::count (m_activity.drops);
+            logDecision (timestamp, DecisionRecord::DROP, input);
+        }
+        break;
+
+    case LOGIC_XOR:
+        //XOR: the first edge opens the window, decided at its end. In immediate mode the
+        //other input decides it false on arrival and the rest of the window is refractory,
+        //so the same windows fire as without it
+        if (!m_windowOpen)
+        {
+            condition = true;
+            openWindow (input, timestamp, WINDOW_END);
+        }
+        else if (m_windowTimer.kind == REFRACTORY_END)
+        {
+            ActivityCounters::count (m_activity.drops);
+            logDecision (timestamp, DecisionRecord::DROP, input);
+        }
+        else
+        {
+            condition = true;
+            if (m_config.immediate && input != m_windowFirstInput)
+            {
+                logDecision (timestamp, DecisionRecord::RESET, input);
+                m_windowTimer.kind = REFRACTORY_END;
+            }
+        }
+        break;
+
+    case LOGIC_DELAY:
+        //DELAY: every edge of A is replayed exactly one window later
+        if (input == 0)
+        {
+            // an overflow is counted by the delay line
+            if (!m_delayLine.push (timestamp))
+            {
+                logDecision (timestamp, DecisionRecord::DROP, input);
+            }
+            else if (!m_delayTimer.isScheduled())
+            {
+                scheduleDelayHead();
+            }
+        }
+        break;
+    }
+}
+
+void GateEngine::openWindow (int input, int64_t timestamp, TimerKind kind)
+{
+    m_windowOpen = true;
+    m_windowStart = timestamp;
+    m_windowFirstInput = input;
+    m_windowFired = false;
+    m_windowTimer.kind = kind;
+    m_timers.schedule (m_windowTimer, timestamp + m_config.windowSamples);
+}
+
+void GateEngine::closeWindow()
+{
+    m_timers.cancel (m_windowTimer);
+    m_windowOpen = false;
+    A = false;
+    B = false;
+}
+
+void GateEngine::scheduleDelayHead()
+{
+    if (!m_delayLine.isEmpty())
+        m_timers.schedule (m_delayTimer, m_delayLine.front() + m_config.windowSamples);
+}
+
+void GateEngine::resetDelay()
+{
+    m_timers.cancel (m_delayTimer);
+    m_delayLine.clear();
+}
+
+void GateEngine::handleTimer (TimerNode& timer)
+{
+    if (timer.kind == PULSE_OFF)
+    {
+        m_listener.gateOutput (timer.when, false, timer.owner);
+        return;
+    }
+
+    if (timer.kind == DELAY_DUE)
+    {
+        m_delayLine.pop();
+        triggerEvent (timer.when, 0);
+        scheduleDelayHead();
+        return;
+    }
+
+    if (timer.kind == WINDOW_END)
+    {
+        switch (m_config.logicOp)
+        {
+        case LOGIC_AND:
+            if (!m_windowFired)
+            {
+                ActivityCounters::count (m_activity.expiredWindows);
+                logDecision (timer.when, DecisionRecord::EXPIRE, -1);
+            }
+            break;
+
+        case LOGIC_OR:
+            if (A || B)
+                triggerEvent (timer.when, -1);
+            break;
+
+        case LOGIC_XOR:
+            if (A != B)
+            {
+                triggerEvent (timer.when, -1);
+            }
+            else
+            {
+                ActivityCounters::count (m_activity.expiredWindows);
+                logDecision (timer.when, DecisionRecord::EXPIRE, -1);
+            }
+            break;
+        }
+    }
+
+    closeWindow();
+}
+
+void GateEngine::triggerEvent (int64_t timestamp, int input)
+{
+    // a replayed DELAY edge ends the pulse still high, every edge comes out as a pulse
+    if (m_config.logicOp == LOGIC_DELAY && m_offTimer.isScheduled())
+    {
+        m_timers.cancel (m_offTimer);
+        m_listener.gateOutput (timestamp, false, m_offTimer.owner);
+    }
+
+    m_listener.gateOutput (timestamp, true, m_config.outputChan);
+    ActivityCounters::count (m_activity.triggers);
+    logDecision (timestamp, DecisionRecord::FIRE, input);
+
+    // other overlapping pulses merge: the line goes low after the last one
+    m_offTimer.owner = m_config.outputChan;
+    m_timers.schedule (m_offTimer, timestamp + m_config.durationSamples);
+}
+
+void GateEngine::logDecision (int64_t timestamp, DecisionRecord::Kind kind, int input)
+{
+    if (m_log != nullptr)
+        m_log->append (timestamp, kind, m_config.logicOp, m_logSource, m_config.outputChan, input);
+    else if (m_records != nullptr)
+        m_records->push_back (DecisionLog::makeRecord (timestamp, kind, m_config.logicOp, m_logSource, m_config.outputChan, input));
+}
@@ -0,0 +1,179 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __GATEENGINE_H_61D0C4B8__
+#define __GATEENGINE_H_61D0C4B8__
+
+#include <cstdint>
+
+#include "TimingWheel.h"
+#include "DelayLine.h"
+#include "ActivityCounters.h"
+#include "DecisionLog.h"
+
+/** Logic operators, in the order of the editor's operator combobox */
+enum LogicOperator
+{
+    LOGIC_AND = 0,
+    LOGIC_OR = 1,
+    LOGIC_XOR = 2,
+    LOGIC_DELAY = 3
+};
+
+/**
+ * @brief The GateConfig struct holds the settings of one gate, with times
+ * already converted to samples (see GateEngine::msToSamples)
+ */
+struct GateConfig
+{
+    int logicOp = LOGIC_AND;
+    bool gate1 = false;
+    bool gate2 = false;
+    bool immediate = false;
+    /** TTL line of the output, -1 for a gate that only feeds other gates */
+    int outputChan = 0;
+    int64_t windowSamples = 0;
+    int64_t durationSamples = 0;
+};
+
+/**
+    The decision logic of the Logic Gate, clocked only by sample timestamps.
+
+    Inputs are rising edges of A (0) and B (1); outputs are TTL edges handed to
+    the Listener. Deadlines live in a TimingWheel, so results do not depend on
+    how time is cut into buffers: the plugin and the offline replay tool feed
+    the same edges and get the same outputs.
+
+    Everything here runs on a single thread (the audio thread in the plugin).
+
+    @see LogicGate
+*/
+class GateEngine
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        /** Called for every output edge, in timestamp order. */
+        virtual void gateOutput (int64_t timestamp, bool on, int outputChan) = 0;
+    };
+
+    explicit GateEngine (Listener& listener);
+
+    /**
+     * @brief setConfig applies new settings. Changing the operator or the
+     * immediate mode drops the current window and any pending DELAY edges.
+     * Changing the output line while a pulse is high ends the pulse on the old line.
+     */
+    void setConfig (const GateConfig& config);
+    const GateConfig& getConfig() const { return m_config; }
+
+    /**
+     * @brief setLog sets the log to write decisions to, nullptr to stop logging
+     * @param source: written as the source of every decision, the gate index in a GateBank
+     */
+    void setLog (DecisionLog* log, int source = 0) { m_log = log; m_records = nullptr; m_logSource = source; }
+    /**
+     * @brief setLogRecords collects decisions in records instead, for an owner that
+     * appends them to the log from another thread later; nullptr to stop
+     */
+    void setLogRecords (std::vector<DecisionRecord>* records, int source = 0) { m_log = nullptr; m_records = records; m_logSource = source; }
+
+    /** Forgets all state and restarts the clock at now, e.g. when acquisition restarts. */
+    void reset (int64_t now);
+    int64_t getNow() const { return m_timers.getNow(); }
+
+    /** Earliest deadline still to fire, INT64_MAX if there is none. */
+    int64_t getNextDeadline() const;
+
+    /** Fires every deadline earlier than until. */
+    void advanceTo (int64_t until);
+
+    /**
+     * @brief inputEdge applies a rising edge, after settling every deadline
+     * up to and including its sample
+     * @param input: 0 for A, 1 for B
+     */
+    void inputEdge (int input, int64_t timestamp);
+
+    const ActivityCounters& getActivity() const { return m_activity; }
+    const DelayLine& getDelayLine() const { return m_delayLine; }
+    void resetCounters();
+
+    /** Window and pulse lengths are rounded up to whole samples, as the plugin always did. */
+    static int64_t msToSamples (int ms, float sampleRate);
+
+private:
+    enum TimerKind
+    {
+        WINDOW_END,
+        REFRACTORY_END,
+        PULSE_OFF,
+        DELAY_DUE
+    };
+
+    void handleTimer (TimerNode& timer);
+    void openWindow (int input, int64_t timestamp, TimerKind kind);
+    void closeWindow();
+    void scheduleDelayHead();
+    void resetDelay();
+    /**
+     * @brief triggerEvent sends the output pulse
+     * @param input: input that decided it, -1 for a deadline
+     */
+    void triggerEvent (int64_t timestamp, int input);
+    void logDecision (int64_t timestamp, DecisionRecord::Kind kind, int input);
+
+    Listener& m_listener;
+    GateConfig m_config;
+    DecisionLog* m_log;
+    std::vector<DecisionRecord>* m_records;
+    int m_logSource;
+
+    // Window opened by the last qualifying edge
+    bool m_windowOpen;
+    int64_t m_windowStart;
+    int m_windowFirstInput;
+    /** The window triggered at least once, so it does not count as expired */
+    bool m_windowFired;
+
+    // Conditions
+    bool A;
+    bool B;
+
+    TimingWheel m_timers;
+    TimerNode m_windowTimer;
+    /** owner holds the output line of the pulse it ends */
+    TimerNode m_offTimer;
+    TimerNode m_delayTimer;
+
+    // Edges waiting to be replayed by DELAY
+    DelayLine m_delayLine;
+
+    ActivityCounters m_activity;
+
+    GateEngine (const GateEngine&) = delete;
+    GateEngine& operator= (const GateEngine&) = delete;
+};
+
+#endif  // __GATEENGINE_H_61D0C4B8__
@@ -0,0 +1,200 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined (_WIN32)
+ #include <windows.h>
+#elif defined (__linux__)
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+#include <chrono>
+#include <vector>
+
+#include "GateWorkerPool.h"
+
+// spin window of idle workers before they sleep
+static const int64_t SPIN_NANOS = 50000;
+// yields between two looks at the clock
+static const int CLOCK_YIELDS = 16;
+
+static int64_t nanosNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t generationOf (uint64_t state)
+{
+    return uint32_t (state >> 32);
+}
+
+GateWorkerPool::GateWorkerPool (int numWorkers)
+    : m_task(nullptr),
+      m_context(nullptr),
+      m_count(0),
+      m_next(0),
+      m_state(0),
+      m_sleeping(0),
+      m_quit(false)
+{
+    const std::vector<int> cores = allowedCores();
+    for (int i = 0; i < numWorkers; i++)
+    {
+        m_workers.emplace_back (&GateWorkerPool::work, this);
+        if (cores.size() > 1)
+            pin (m_workers.back(), cores[(i + 1) % cores.size()]);
+    }
+}
+
+GateWorkerPool::~GateWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock (m_lock);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+std::vector<int> GateWorkerPool::allowedCores()
+{
+    std::vector<int> cores;
+#if defined (_WIN32)
+    DWORD_PTR process = 0;
+    DWORD_PTR system = 0;
+    if (GetProcessAffinityMask (GetCurrentProcess(), &process, &system))
+        for (int core = 0; core < int (sizeof (DWORD_PTR) * 8); core++)
+            if ((process >> core) & 1)
+                cores.push_back (core);
+#elif defined (__linux__)
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    if (sched_getaffinity (0, sizeof (set), &set) == 0)
+        for (int core = 0; core < CPU_SETSIZE; core++)
+            if (CPU_ISSET (core, &set))
+                cores.push_back (core);
+#endif
+    return cores;
+}
+
+void GateWorkerPool::pin (std::thread& thread, int core)
+{
+#if defined (_WIN32)
+    if (core < 64)
+        SetThreadAffinityMask (thread.native_handle(), DWORD_PTR (1) << core);
+#elif defined (__linux__)
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    CPU_SET (core, &set);
+    pthread_setaffinity_np (thread.native_handle(), sizeof (set), &set);
+#else
+    // macOS only takes affinity hints, leave placement to the scheduler
+    (void) thread;
+    (void) core;
+#endif
+}
+
+void GateWorkerPool::run (int count, Task task, void* context)
+{
+    if (count <= 0)
+        return;
+
+    m_task = task;
+    m_context = context;
+    m_count = count;
+    m_next.store (0, std::memory_order_relaxed);
+
+    // the last batch was closed with nobody in it. seq_cst pairs with the sleeping
+    // count, which a worker raises before it checks the generation under the lock;
+    // notifying under the lock reaches a worker between that check and its wait
+    const uint32_t generation = generationOf (m_state.load (std::memory_order_relaxed)) + 1;
+    m_state.store ((uint64_t (generation) << 32) | OPEN);
+    if (m_sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock (m_lock);
+        m_wake.notify_all();
+    }
+
+    runItems();
+
+    // every item is taken: close the batch, then wait for the workers still running
+    // their last one, which is no longer than an item of the calling thread
+    m_state.fetch_and (~OPEN, std::memory_order_acq_rel);
+    while ((m_state.load (std::memory_order_acquire) & JOINED) != 0)
+        std::this_thread::yield();
+}
+
+void GateWorkerPool::runItems()
+{
+    for (;;)
+    {
+        const int item = m_next.fetch_add (1, std::memory_order_relaxed);
+        if (item >= m_count)
+            return;
+        m_task (m_context, item);
+    }
+}
+
+bool GateWorkerPool::waitForBatch (uint32_t seen)
+{
+    int64_t idleSince = nanosNow();
+    int spins = 0;
+    while (generationOf (m_state.load (std::memory_order_acquire)) == seen)
+    {
+        if (m_quit.load())
+            return false;
+
+        std::this_thread::yield();
+        if (++spins % CLOCK_YIELDS != 0 || nanosNow() - idleSince < SPIN_NANOS)
+            continue;
+
+        std::unique_lock<std::mutex> lock (m_lock);
+        m_sleeping.fetch_add (1);
+        m_wake.wait (lock, [this, seen] { return generationOf (m_state.load()) != seen || m_quit.load(); });
+        m_sleeping.fetch_sub (1);
+        idleSince = nanosNow();
+    }
+    return !m_quit.load();
+}
+
+void GateWorkerPool::work()
+{
+    uint32_t seen = 0;
+
+    while (waitForBatch (seen))
+    {
+        // join the batch only while it is open, a late worker leaves it alone
+        uint64_t state = m_state.load (std::memory_order_acquire);
+        seen = generationOf (state);
+        while ((state & OPEN) != 0 && generationOf (state) == seen)
+        {
+            if (m_state.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel))
+            {
+                runItems();
+                m_state.fetch_sub (1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __GATEWORKERPOOL_H_5E0B3F27__
+#define __GATEWORKERPOOL_H_5E0B3F27__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+    Worker threads that stay alive across buffers to help the audio thread.
+
+    run() publishes a batch of items and works on it together with the
+    workers; items are handed out through one atomic counter. Only workers
+    that are awake when the batch starts join it, and run() waits for those
+    alone, so a sleeping worker never delays a buffer. After a batch the
+    workers spin for 50 us, which catches batches that come back to back,
+    then sleep until the next batch wakes them, so idle cores are released
+    between buffers.
+    Where the platform allows it (Linux, Windows), worker k is pinned to the
+    k + 1th core of the process affinity mask, leaving the first to the rest
+    of the GUI.
+
+    Threads are started and stopped with the pool, from the message thread.
+
+    @see GateBank
+*/
+class GateWorkerPool
+{
+public:
+    typedef void (*Task) (void* context, int item);
+
+    explicit GateWorkerPool (int numWorkers);
+    ~GateWorkerPool();
+
+    int getNumWorkers() const { return int (m_workers.size()); }
+
+    /**
+     * @brief run calls task(context, i) for every i in [0, count) on the workers
+     * and the calling thread, and returns once all of them are done. Locks only
+     * to wake sleeping workers, which join the batch if it is still open.
+     */
+    void run (int count, Task task, void* context);
+
+private:
+    void work();
+    void runItems();
+    /** Waits for a batch other than seen, false when the pool is stopping */
+    bool waitForBatch (uint32_t seen);
+    /** Cores the process may run on, empty where the platform does not say */
+    static std::vector<int> allowedCores();
+    static void pin (std::thread& thread, int core);
+
+    std::vector<std::thread> m_workers;
+
+    // the batch, written before it is opened in m_state
+    Task m_task;
+    void* m_context;
+    int m_count;
+    std::atomic<int> m_next;
+
+    /**
+     * Batch generation in the high 32 bits, OPEN while workers may join,
+     * and the number of workers in the batch in the low bits
+     */
+    std::atomic<uint64_t> m_state;
+    static const uint64_t OPEN = uint64_t (1) << 31;
+    static const uint64_t JOINED = OPEN - 1;
+
+    std::atomic<int> m_sleeping;
+    std::atomic<bool> m_quit;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+
+    GateWorkerPool (const GateWorkerPool&) = delete;
+    GateWorkerPool& operator= (const GateWorkerPool&) = delete;
+};
+
+#endif  // __GATEWORKERPOOL_H_5E0B3F27__
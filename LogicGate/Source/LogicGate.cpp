@@ -36,24 +36,46 @@
 
 #include "LogicGate.h"
 #include "LogicGateEditor.h"
-
+#include "ControlServer.h"
+
+
+GateSettings::GateSettings()
+    : input1(-1),
+      input2(-1),
+      input1gate(false),
+      input2gate(false),
+      logicOp(0),
+      outputChan(0),
+      window(DEF_WINDOW),
+      duration(2),
+      immediate(false)
+{
+}
 
 LogicGate::LogicGate()
     : GenericProcessor ("Logic Gate"),
-      m_logicOp(0),
-      m_outputChan(0),
-      m_window(DEF_WINDOW),
-      m_input1(-1),
-      m_input2(-1),
-      m_input1gate(false),
-      m_input2gate(false),
-      m_pulseDuration(2)
+      m_bufferStart(0),
+      m_bufferSamples(0),
+      m_firstBuffer(true),
+      m_bank(*this),
+      m_numThreads(1),
+      m_acquiring(false),
+      m_pendingWiring(nullptr),
+      m_retiredWirings(nullptr),
+      m_logEnabled(false),
+      m_logging(false),
+      m_traceEnabled(false),
+      m_controlPort(0)
 {
     setProcessorType (PROCESSOR_TYPE_FILTER);
+    m_gates.add (GateSettings());
+    m_bufferEdges.reserve (BUFFER_EDGES);
 }
 
 LogicGate::~LogicGate()
 {
+    m_controlServer = nullptr;
+    freeWirings(true);
 }
 
 AudioProcessorEditor* LogicGate::createEditor()
@@ -64,249 +86,589 @@ AudioProcessorEditor* LogicGate::createEditor()
 
 void LogicGate::createEventChannels()
 {
-    EventChannel* ev = new EventChannel(EventChannel::TTL, 8, 1, CoreServices::getGlobalSampleRate(), this);
+    // outputs are stamped in the sample clock of the processor's own stream
+    EventChannel* ev = new EventChannel(EventChannel::TTL, 8, 1, getSampleRate(), this);
     ev->setName("Logic Gate TTL output" );
     ev->setDescription("Triggers when logic operator is satisfied.");
     ev->setIdentifier ("dataderived.logicgate.trigger");
     eventChannelArray.add (ev);
 }
 
+bool LogicGate::enable()
+{
+    // the audio thread starts from a copy of the settings, later changes reach it as commands.
+    // Gates are only added or removed while stopped, the bank is resized here
+    m_audioGates = m_gates;
+    m_commands.clear();
+    freeWirings(true);
+    m_bufferEdges.clear();
+    m_firstBuffer = true;
+    m_acquiring = true;
+
+    for (int i = 0; i < m_streams.size(); i++)
+    {
+        StreamClock& clock = m_streams.getReference(i);
+        clock.scale = clock.sampleRate > 0 ? getSampleRate() / clock.sampleRate : 1.0;
+        clock.offset = 0.5;
+    }
+
+    std::vector<GateBank::Gate> gates;
+    makeBankGates(m_audioGates, gates);
+    m_bank.setNumThreads(m_numThreads);
+    if (!m_bank.setGates(gates))
+    {
+        // the bank would keep its old size while commands address the new gates
+        m_acquiring = false;
+        CoreServices::sendStatusMessage("Logic Gate: the gate inputs form a loop, acquisition not started");
+        return false;
+    }
+    m_bank.resetCounters();
+
+    if (!m_watchdog.isCalibrated())
+        m_watchdog.calibrate();
+    m_watchdog.reset();
+
+    if (m_logEnabled)
+    {
+        File logFile = File::getSpecialLocation(File::userDocumentsDirectory)
+                       .getChildFile("LogicGate_" + Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S") + ".lgdlog");
+        m_logging = m_log.start(logFile.getFullPathName().toStdString(), getSampleRate());
+        if (m_logging)
+        {
+            m_bank.setLog(&m_log);
+            std::cout << "Logic Gate decision log: " << logFile.getFullPathName() << std::endl;
+        }
+        else
+            CoreServices::sendStatusMessage("Logic Gate: could not open " + logFile.getFullPathName());
+    }
+    return true;
+}
+
+bool LogicGate::disable()
+{
+    m_acquiring = false;
+
+    if (m_traceEnabled && m_watchdog.getBuffers() > 0)
+    {
+        File traceFile = File::getSpecialLocation(File::userDocumentsDirectory)
+                         .getChildFile("LogicGate_" + Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S") + "_slowest.csv");
+        if (m_watchdog.writeSlowest(traceFile.getFullPathName().toStdString()))
+            std::cout << "Logic Gate slowest buffers: " << traceFile.getFullPathName() << std::endl;
+    }
+    if (m_watchdog.getOverruns() > 0)
+        std::cout << "Logic Gate overran " << m_watchdog.getOverruns() << " of " << m_watchdog.getBuffers()
+                  << " buffers, worst " << m_watchdog.getWorstLoad() << "% of the budget" << std::endl;
+
+    freeWirings(true);
+
+    if (m_logging)
+    {
+        m_logging = false;
+        m_bank.setLog(nullptr);
+        m_log.stop();
+        if (m_log.getDroppedRecords() > 0)
+            std::cout << "Logic Gate decision log dropped " << m_log.getDroppedRecords() << " records" << std::endl;
+    }
+    return true;
+}
+
 void LogicGate::handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum)
 {
     if (Event::getEventType(event) == EventChannel::TTL)
     {
+        const uint64 started = ProcessWatchdog::readCounter();
+
         TTLEventPtr ttl = TTLEvent::deserializeFromMessage(event, eventInfo);
         const int state         = ttl->getState() ? 1 : 0;
         const int eventId       = ttl->getSourceIndex();
         const int sourceId      = ttl->getSourceID();
         const int eventChannel  = ttl->getChannel();
+        const int source        = findSource(eventId, sourceId, eventChannel);
 
-        if (m_input1 != -1)
+        // timestamps of other streams are brought into the output clock. Conversion can
+        // reorder edges of different streams, they are sorted at the end of the buffer
+        int64 timestamp = ttl->getTimestamp();
+        if (source != -1)
         {
-            EventSources s = m_sources.getReference (m_input1);
-            if (eventId == s.eventIndex && sourceId == s.sourceId
-                    && eventChannel == s.channel && state)
-            {
-                std::cout << "Received A " << std::endl;
-                A = true;
+            StreamClock& clock = m_streams.getReference(m_sources.getReference(source).stream);
+            const int64 converted = clock.toOutput(timestamp);
+
+            // an edge is delivered with the buffer it happened in: an event-only stream
+            // whose clock puts it elsewhere is re-anchored at the start of this buffer
+            if (clock.eventOnly && (converted < m_bufferStart || converted >= m_bufferStart + m_bufferSamples))
+                clock.offset = m_bufferStart - timestamp * clock.scale + 0.5;
+            timestamp = clock.toOutput(timestamp);
+        }
 
-                if ((m_input1gate) || (!m_input1gate && !m_input2gate))
-                    m_previousTime = Time::currentTimeMillis();
-            }
+        BufferEdge edge = { timestamp, source, state, sourceId, eventChannel, false };
+        m_bufferEdges.push_back(edge);
+
+        m_watchdog.addEventTicks(ProcessWatchdog::readCounter() - started);
+    }
+}
+
+int LogicGate::findSource(int eventIndex, int sourceId, int channel)
+{
+    for (int i = 0; i < m_sources.size(); i++)
+    {
+        const EventSources& s = m_sources.getReference (i);
+        if (eventIndex == s.eventIndex && sourceId == s.sourceId && channel == s.channel)
+            return i;
+    }
+    return -1;
+}
+
+int LogicGate::getNumGates()
+{
+    return m_gates.size();
+}
+
+int LogicGate::addGate()
+{
+    if (m_acquiring)
+        return -1;
+
+    m_gates.add (GateSettings());
+    return m_gates.size() - 1;
+}
+
+void LogicGate::removeGate(int gate)
+{
+    if (m_acquiring || m_gates.size() <= 1 || gate < 0 || gate >= m_gates.size())
+        return;
+
+    m_gates.remove (gate);
+
+    // inputs reading the removed gate are disconnected, the ones after it move down
+    for (int g = 0; g < m_gates.size(); g++)
+    {
+        int* inputs[2] = { &m_gates.getReference(g).input1, &m_gates.getReference(g).input2 };
+        for (int i = 0; i < 2; i++)
+        {
+            if (!GateBank::isGateInput (*inputs[i]))
+                continue;
+            const int upstream = GateBank::inputGate (*inputs[i]);
+            if (upstream == gate)
+                *inputs[i] = GateBank::NO_INPUT;
+            else if (upstream > gate)
+                *inputs[i] = GateBank::gateInput (upstream - 1);
         }
+    }
+}
+
+bool LogicGate::canUseInput(int gate, int slot, int input)
+{
+    if (!GateBank::isGateInput (input))
+        return true;
+    if (GateBank::inputGate (input) == gate || GateBank::inputGate (input) >= m_gates.size())
+        return false;
+
+    // a gate reading itself through other gates would never settle
+    std::vector<GateBank::Gate> gates (m_gates.size());
+    for (int g = 0; g < m_gates.size(); g++)
+    {
+        gates[g].inputs[0] = m_gates[g].input1;
+        gates[g].inputs[1] = m_gates[g].input2;
+    }
+    gates[gate].inputs[slot] = input;
+
+    std::vector<int> order;
+    return GateBank::sortGates (gates, order);
+}
+
+static void applyCommand(GateSettings& gate, int param, int value)
+{
+    switch (param)
+    {
+    case GateCommand::INPUT1:    gate.input1 = value; break;
+    case GateCommand::INPUT2:    gate.input2 = value; break;
+    case GateCommand::GATE1:     gate.input1gate = value != 0; break;
+    case GateCommand::GATE2:     gate.input2gate = value != 0; break;
+    case GateCommand::LOGIC_OP:  gate.logicOp = value; break;
+    case GateCommand::OUTPUT:    gate.outputChan = value; break;
+    case GateCommand::WINDOW:    gate.window = value; break;
+    case GateCommand::DURATION:  gate.duration = value; break;
+    case GateCommand::IMMEDIATE: gate.immediate = value != 0; break;
+    }
+}
+
+bool LogicGate::setParameter(int gate, int param, int value)
+{
+    const bool rewire = param == GateCommand::INPUT1 || param == GateCommand::INPUT2;
 
-        if (m_input2 != -1)
+    // the audio thread must get the change before it shows up in the settings
+    if (m_acquiring && !rewire)
+    {
+        GateCommand command = { gate, param, value };
+        if (!m_commands.push(command))
         {
-            EventSources s = m_sources.getReference (m_input2);
-            if (eventId == s.eventIndex && sourceId == s.sourceId
-                    && eventChannel == s.channel && state)
-            {
-                std::cout << "Received B " << std::endl;
-                B = true;
-                if ((m_input2gate) || (!m_input1gate && !m_input2gate))
-                    m_previousTime = Time::currentTimeMillis();
-            }
+            CoreServices::sendStatusMessage("Logic Gate: too many changes at once, some were not applied");
+            return false;
         }
     }
+
+    applyCommand(m_gates.getReference(gate), param, value);
+
+    // rewiring is worked out here, the audio thread only swaps it in
+    if (m_acquiring && rewire)
+        publishWiring();
+    return true;
 }
 
+void LogicGate::publishWiring()
+{
+    freeWirings(false);
+
+    std::vector<GateBank::Gate> gates;
+    makeBankGates(m_gates, gates);
+    PendingWiring* pending = new PendingWiring();
+    pending->wiring = GateBank::makeWiring(gates, m_bank.isParallel());
+    pending->next = nullptr;
+
+    // canUseInput keeps loops out, a rejected wiring leaves the current one
+    if (pending->wiring == nullptr)
+    {
+        delete pending;
+        return;
+    }
 
-void LogicGate::setInput1(int i1)
+    // one the audio thread has not taken yet is out of date
+    delete m_pendingWiring.exchange(pending);
+}
+
+void LogicGate::freeWirings(bool discard)
 {
-    m_input1 = i1;
+    if (discard)
+        delete m_pendingWiring.exchange(nullptr);
+
+    PendingWiring* retired = m_retiredWirings.exchange(nullptr);
+    while (retired != nullptr)
+    {
+        PendingWiring* next = retired->next;
+        delete retired;
+        retired = next;
+    }
 }
-void LogicGate::setInput2(int i2)
+
+bool LogicGate::setInput1(int gate, int i1)
 {
-    m_input2 = i2;
+    return setParameter(gate, GateCommand::INPUT1, i1);
 }
-void LogicGate::setGate1(bool set)
+bool LogicGate::setInput2(int gate, int i2)
 {
-    m_input1gate = set;
+    return setParameter(gate, GateCommand::INPUT2, i2);
 }
-void LogicGate::setGate2(bool set)
+bool LogicGate::setGate1(int gate, bool set)
 {
-    m_input2gate = set;
+    return setParameter(gate, GateCommand::GATE1, set);
 }
-void LogicGate::setLogicOp(int op)
+bool LogicGate::setGate2(int gate, bool set)
 {
-    m_logicOp = op;
+    return setParameter(gate, GateCommand::GATE2, set);
 }
-void LogicGate::setOutput(int out)
+bool LogicGate::setLogicOp(int gate, int op)
 {
-    m_outputChan = out;
+    return setParameter(gate, GateCommand::LOGIC_OP, op);
 }
-void LogicGate::setWindow(int win)
+bool LogicGate::setOutput(int gate, int out)
 {
-    m_window = win;
+    return setParameter(gate, GateCommand::OUTPUT, out);
 }
-void LogicGate::setTtlDuration(int dur)
+bool LogicGate::setWindow(int gate, int win)
 {
-    m_pulseDuration = dur;
+    return setParameter(gate, GateCommand::WINDOW, win);
+}
+bool LogicGate::setTtlDuration(int gate, int dur)
+{
+    return setParameter(gate, GateCommand::DURATION, dur);
+}
+void LogicGate::setLogEnabled(bool set)
+{
+    m_logEnabled = set;
+}
+bool LogicGate::setImmediate(int gate, bool set)
+{
+    return setParameter(gate, GateCommand::IMMEDIATE, set);
 }
 
-int LogicGate::getInput1()
+int LogicGate::getInput1(int gate)
 {
-    return m_input1;
+    return m_gates[gate].input1;
 }
-int LogicGate::getInput2()
+int LogicGate::getInput2(int gate)
 {
-    return m_input2;
+    return m_gates[gate].input2;
 }
-bool LogicGate::getGate1()
+bool LogicGate::getGate1(int gate)
 {
-    return m_input1gate;
+    return m_gates[gate].input1gate;
 }
-bool LogicGate::getGate2()
+bool LogicGate::getGate2(int gate)
 {
-    return m_input2gate;
+    return m_gates[gate].input2gate;
 }
-int LogicGate::getLogicOp()
+int LogicGate::getLogicOp(int gate)
 {
-    return m_logicOp;
+    return m_gates[gate].logicOp;
 }
-int LogicGate::getOutput()
+int LogicGate::getOutput(int gate)
 {
-    return m_outputChan;
+    return m_gates[gate].outputChan;
 }
-int LogicGate::getWindow()
+int LogicGate::getWindow(int gate)
 {
-    return m_window;
+    return m_gates[gate].window;
 }
-int LogicGate::getTtlDuration()
+int LogicGate::getTtlDuration(int gate)
 {
-    return m_pulseDuration;
+    return m_gates[gate].duration;
+}
+bool LogicGate::getImmediate(int gate)
+{
+    return m_gates[gate].immediate;
+}
+bool LogicGate::getLogEnabled()
+{
+    return m_logEnabled;
+}
+int LogicGate::getNumSources()
+{
+    return m_sources.size();
 }
 
-void LogicGate::process (AudioSampleBuffer& buffer)
+void LogicGate::setControlPort(int port)
 {
-    checkForEvents ();
-    // implement logic
-    m_currentTime = Time::currentTimeMillis();
-    m_timePassed = float(m_currentTime - m_previousTime);
+    m_controlServer = nullptr;
+    m_controlPort = port;
 
-    switch (m_logicOp)
+    if (port > 0)
     {
-    case 0:
-        //AND: as soon as AND is true send TTL output
-        if (m_timePassed < m_window)
-        {
-            if (A && B)
-            {
-                std::cout << "AND condition satisfied ";
-                triggerEvent();
-
-                if ((m_input1gate == m_input2gate))
-                {
-                    std::cout << "resetting input" << std::endl;
-                    A = false;
-                    B = false;
-                }
-                else if (!m_input1gate)
-                {
-                    std::cout << "resetting A" << std::endl;
-                    A = false;
-                }
-                else if (!m_input2gate)
-                {
-                    std::cout << "resetting B" << std::endl;
-                    B = false;
-                }
-            }
-            m_previousTime = Time::currentTimeMillis();
-        }
-        else
+        m_controlServer = new ControlServer(*this);
+        if (!m_controlServer->start(port))
         {
-            A = false;
-            B = false;
+            m_controlServer = nullptr;
+            CoreServices::sendStatusMessage("Logic Gate: could not listen on port " + String(port));
         }
-        break;
+    }
+}
+int LogicGate::getControlPort()
+{
+    return m_controlPort;
+}
+void LogicGate::setTraceEnabled(bool set)
+{
+    m_traceEnabled = set;
+}
+bool LogicGate::getTraceEnabled()
+{
+    return m_traceEnabled;
+}
+void LogicGate::setNumThreads(int threads)
+{
+    m_numThreads = jlimit(1, jmax(1, SystemStats::getNumCpus()), threads);
+}
+int LogicGate::getNumThreads()
+{
+    return m_numThreads;
+}
 
-    case 1:
-        //OR: if OR is true send TTL at the end of thw window
-        if (m_timePassed > m_window)
-        {
-            if (A || B)
-            {
-                std::cout << "OR condition satisfied: resetting input" << std::endl;
-                triggerEvent();
+const ProcessWatchdog& LogicGate::getWatchdog()
+{
+    return m_watchdog;
+}
 
-                A = false;
-                B = false;
-            }
-            else
-            {
-                A = false;
-                B = false;
-            }
-            m_previousTime = Time::currentTimeMillis();
-        }
-        break;
+uint64 LogicGate::getDelayOverflows(int gate)
+{
+    return gate < m_bank.getNumGates() ? m_bank.getGate(gate).getDelayLine().getOverflowCount() : 0;
+}
+int LogicGate::getDelayHighWaterMark(int gate)
+{
+    return gate < m_bank.getNumGates() ? m_bank.getGate(gate).getDelayLine().getHighWaterMark() : 0;
+}
 
-    case 2:
-        //XOR: if XOR is true send TTL at the end of thw window
-        if (m_timePassed > m_window)
-        {
-            if (A != B)
-            {
-                std::cout << "XOR condition satisfied: resetting input" << std::endl;
-                triggerEvent();
+const ActivityCounters& LogicGate::getActivity(int gate)
+{
+    // a gate added since the last acquisition has not counted anything yet
+    static const ActivityCounters none;
+    return gate < m_bank.getNumGates() ? m_bank.getGate(gate).getActivity() : none;
+}
 
-                A = false;
-                B = false;
-            }
-            else if ((A == B) && (A))
-            {
-                std::cout << "XOR condition NOT satisfied: resetting input" << std::endl;
-                A = false;
-                B = false;
-            }
-            else
-            {
-                A = false;
-                B = false;
-            }
-            m_previousTime = Time::currentTimeMillis();
-        }
-        break;
+void LogicGate::makeBankGates(const Array<GateSettings>& settings, std::vector<GateBank::Gate>& gates)
+{
+    gates.resize(settings.size());
+
+    for (int g = 0; g < settings.size(); g++)
+    {
+        gates[g].inputs[0] = settings.getReference(g).input1;
+        gates[g].inputs[1] = settings.getReference(g).input2;
+        gates[g].config = makeGateConfig(settings.getReference(g));
+    }
+}
+
+GateConfig LogicGate::makeGateConfig(const GateSettings& settings)
+{
+    const float sampleRate = getSampleRate();
+
+    GateConfig config;
+    config.logicOp = settings.logicOp;
+    config.gate1 = settings.input1gate;
+    config.gate2 = settings.input2gate;
+    config.immediate = settings.immediate;
+    config.outputChan = settings.outputChan;
+    config.windowSamples = GateEngine::msToSamples(settings.window, sampleRate);
+    config.durationSamples = GateEngine::msToSamples(settings.duration, sampleRate);
+    return config;
+}
+
+void LogicGate::process (AudioSampleBuffer& buffer)
+{
+    const uint64 started = ProcessWatchdog::readCounter();
 
-    case 3: //DELAY
-        if (m_timePassed > m_window)
+    m_bufferStart = getNumInputs() > 0 ? getTimestamp(0) : CoreServices::getGlobalTimestamp();
+    m_bufferSamples = getNumInputs() > 0 ? getNumSamples(0) : buffer.getNumSamples();
+    updateStreamClocks();
+
+    // the sample clock starts over with every acquisition
+    if (m_firstBuffer)
+    {
+        m_bank.reset(m_bufferStart);
+        m_firstBuffer = false;
+    }
+
+    if (PendingWiring* pending = m_pendingWiring.exchange(nullptr))
+    {
+        // the pending wiring comes back holding the one it replaced. Installed before the
+        // commands so that what they mark dirty is ranked in the wiring the bank settles with
+        m_bank.swapWiring(pending->wiring);
+        pending->next = m_retiredWirings.load();
+        while (!m_retiredWirings.compare_exchange_weak(pending->next, pending))
+            ;
+    }
+
+    // settings changed since the last buffer take effect from this one, without allocating
+    GateCommand command;
+    while (m_commands.pop(command))
+    {
+        if (command.gate < m_audioGates.size())
         {
-            if (A)
-            {
-                std::cout << "DELAY A" << std::endl;
-                triggerEvent();
-                A = false;
-            }
-            m_previousTime = Time::currentTimeMillis();
+            GateSettings& settings = m_audioGates.getReference(command.gate);
+            applyCommand(settings, command.param, command.value);
+            m_bank.setConfig(command.gate, makeGateConfig(settings));
         }
-        break;
     }
+
+    checkForEvents ();
+    feedEdges(m_bufferStart + m_bufferSamples);
+
+    // only the deadlines falling inside this buffer are visited
+    m_bank.advanceTo(m_bufferStart + m_bufferSamples);
+
+    m_watchdog.endBuffer(started, m_bufferStart, m_bufferSamples, getSampleRate());
+}
+
+void LogicGate::feedEdges(int64 end)
+{
+    // an edge waits for one buffer at most, then takes the last sample of this one
+    for (BufferEdge& edge : m_bufferEdges)
+        if (edge.held && edge.timestamp >= end)
+            edge.timestamp = end - 1;
+
+    // edges arrive nearly sorted, stream by stream: an insertion sort is cheap and
+    // keeps edges with the same timestamp in delivery order
+    for (size_t i = 1; i < m_bufferEdges.size(); i++)
+    {
+        const BufferEdge edge = m_bufferEdges[i];
+        size_t j = i;
+        for (; j > 0 && m_bufferEdges[j - 1].timestamp > edge.timestamp; j--)
+            m_bufferEdges[j] = m_bufferEdges[j - 1];
+        m_bufferEdges[j] = edge;
+    }
+
+    // feeding the bank is the rest of the events' handling, counted with handleEvent's
+    const uint64 started = ProcessWatchdog::readCounter();
+    size_t fed = 0;
+    for (; fed < m_bufferEdges.size() && m_bufferEdges[fed].timestamp < end; fed++)
+    {
+        const BufferEdge& edge = m_bufferEdges[fed];
+
+        // the bank cannot go back, an edge converted into an already settled sample takes the first open one
+        const int64 timestamp = jmax<int64>(edge.timestamp, m_bank.getNow());
+
+        // deadlines up to and including this sample are settled before the edge is logged,
+        // with worker threads the bank is only settled at the end of the buffer
+        if (!m_bank.isParallel())
+            m_bank.advanceTo(timestamp + 1);
+
+        if (m_logging)
+            m_log.append(timestamp, DecisionRecord::EDGE, edge.state, edge.sourceId, edge.channel, edge.source);
+
+        if (edge.source != -1 && edge.state)
+            m_bank.inputEdge(edge.source, timestamp);
+    }
+    m_watchdog.addEventTicks(ProcessWatchdog::readCounter() - started, 0);
+    m_bufferEdges.erase(m_bufferEdges.begin(), m_bufferEdges.begin() + fed);
+    for (BufferEdge& edge : m_bufferEdges)
+        edge.held = true;
 }
 
-void LogicGate::triggerEvent()
+void LogicGate::gateOutput(int64_t timestamp, bool on, int outputChan)
 {
-    int64 timestamp = CoreServices::getGlobalTimestamp();
-    setTimestampAndSamples(timestamp, 0);
-    uint8 ttlData = 1 << m_outputChan;
+    if (on)
+        setTimestampAndSamples(m_bufferStart, 0);
+
+    const int sampleNum = static_cast<int>(jlimit<int64>(0, jmax(m_bufferSamples - 1, 0), timestamp - m_bufferStart));
+    uint8 ttlData = on ? (1 << outputChan) : 0;
     const EventChannel* chan = getEventChannel(getEventChannelIndex(0, getNodeId()));
-    TTLEventPtr event = TTLEvent::createTTLEvent(chan, timestamp, &ttlData, sizeof(uint8), m_outputChan);
-    addEvent(chan, event, 0);
+    TTLEventPtr event = TTLEvent::createTTLEvent(chan, timestamp, &ttlData, sizeof(uint8), outputChan);
+    addEvent(chan, event, sampleNum);
+}
 
-    int eventDurationSamp = static_cast<int>(ceil(m_pulseDuration / 1000.0f * getSampleRate()));
-    uint8 ttlDataOff = 0;
-    TTLEventPtr eventOff = TTLEvent::createTTLEvent(chan, timestamp + eventDurationSamp, &ttlDataOff, sizeof(uint8), m_outputChan);
-    addEvent(chan, eventOff, 0);
+void LogicGate::updateStreamClocks()
+{
+    for (int i = 0; i < m_streams.size(); i++)
+    {
+        StreamClock& clock = m_streams.getReference(i);
+
+        // event-only streams have no blocks, their edges anchor them (see handleEvent)
+        clock.eventOnly = getNumSourceSamples(clock.sourceId, clock.subProcessor) == 0;
+        if (clock.eventOnly)
+            continue;
+
+        const int64 streamStart = getSourceTimestamp(clock.sourceId, clock.subProcessor);
+        clock.offset = m_bufferStart - streamStart * clock.scale + 0.5;
+    }
 }
 
 void LogicGate::addEventSource(EventSources s)
 {
+    s.stream = -1;
+    for (int i = 0; i < m_streams.size() && s.stream == -1; i++)
+    {
+        const StreamClock& clock = m_streams.getReference(i);
+        if (clock.sourceId == s.sourceId && clock.subProcessor == s.subProcessor)
+            s.stream = i;
+    }
+
+    if (s.stream == -1)
+    {
+        StreamClock clock;
+        clock.sourceId = s.sourceId;
+        clock.subProcessor = s.subProcessor;
+        clock.sampleRate = s.sampleRate;
+        clock.scale = 1.0;
+        clock.offset = 0.5;
+        clock.eventOnly = false;
+        s.stream = m_streams.size();
+        m_streams.add (clock);
+    }
+
     m_sources.add (s);
 }
 
 void LogicGate::clearEventSources()
 {
     m_sources.clear();
+    m_streams.clear();
 }
 
 
@@ -314,15 +676,41 @@ void LogicGate::saveCustomParametersToXml(XmlElement *parentElement)
 {
     XmlElement* mainNode = parentElement->createNewChildElement("LogicGate");
 
-    mainNode->setAttribute("input1", m_input1);
-    mainNode->setAttribute("input2", m_input2);
-    mainNode->setAttribute("input1gate", m_input1gate);
-    mainNode->setAttribute("input2gate", m_input2gate);
-    mainNode->setAttribute("logicOp", m_logicOp);
-    mainNode->setAttribute("outputChan", m_outputChan);
-    mainNode->setAttribute("window", m_window);
-    mainNode->setAttribute("duration", m_pulseDuration);
+    mainNode->setAttribute("decisionLog", m_logEnabled);
+    mainNode->setAttribute("controlPort", m_controlPort);
+    mainNode->setAttribute("slowestTrace", m_traceEnabled);
+    mainNode->setAttribute("threads", m_numThreads);
 
+    for (int g = 0; g < m_gates.size(); g++)
+    {
+        const GateSettings& gate = m_gates.getReference(g);
+        XmlElement* gateNode = mainNode->createNewChildElement("GATE");
+
+        gateNode->setAttribute("input1", gate.input1);
+        gateNode->setAttribute("input2", gate.input2);
+        gateNode->setAttribute("input1gate", gate.input1gate);
+        gateNode->setAttribute("input2gate", gate.input2gate);
+        gateNode->setAttribute("logicOp", gate.logicOp);
+        gateNode->setAttribute("outputChan", gate.outputChan);
+        gateNode->setAttribute("window", gate.window);
+        gateNode->setAttribute("duration", gate.duration);
+        gateNode->setAttribute("immediate", gate.immediate);
+    }
+}
+
+static GateSettings loadGateSettings(const XmlElement* node)
+{
+    GateSettings gate;
+    gate.input1 = node->getIntAttribute("input1", -1);
+    gate.input2 = node->getIntAttribute("input2", -1);
+    gate.input1gate = node->getBoolAttribute("input1gate");
+    gate.input2gate = node->getBoolAttribute("input2gate");
+    gate.logicOp = node->getIntAttribute("logicOp");
+    gate.outputChan = node->getIntAttribute("outputChan");
+    gate.window = node->getIntAttribute("window", DEF_WINDOW);
+    gate.duration = node->getIntAttribute("duration", 2);
+    gate.immediate = node->getBoolAttribute("immediate", false);
+    return gate;
 }
 
 void LogicGate::loadCustomParametersFromXml ()
@@ -333,14 +721,37 @@ void LogicGate::loadCustomParametersFromXml ()
         {
             if (mainNode->hasTagName ("LogicGate"))
             {
-                m_input1 = mainNode->getIntAttribute("input1");
-                m_input2 = mainNode->getIntAttribute("input2");
-                m_input1gate = mainNode->getBoolAttribute("input1gate");
-                m_input2gate = mainNode->getBoolAttribute("input2gate");
-                m_logicOp = mainNode->getIntAttribute("logicOp");
-                m_outputChan = mainNode->getIntAttribute("outputChan");
-                m_window = mainNode->getIntAttribute("window");
-                m_pulseDuration = mainNode->getIntAttribute("duration");
+                m_gates.clear();
+                forEachXmlChildElementWithTagName (*mainNode, gateNode, "GATE")
+                    m_gates.add (loadGateSettings(gateNode));
+
+                // settings saved before gates could be chained hold a single gate
+                if (m_gates.size() == 0)
+                    m_gates.add (loadGateSettings(mainNode));
+
+                // a damaged file may read a missing gate or close a loop, those inputs are disconnected
+                std::vector<int> inputs;
+                for (int g = 0; g < m_gates.size(); g++)
+                {
+                    GateSettings& gate = m_gates.getReference(g);
+                    inputs.push_back(gate.input1);
+                    inputs.push_back(gate.input2);
+                    gate.input1 = GateBank::NO_INPUT;
+                    gate.input2 = GateBank::NO_INPUT;
+                }
+                for (int g = 0; g < m_gates.size(); g++)
+                {
+                    GateSettings& gate = m_gates.getReference(g);
+                    if (canUseInput(g, 0, inputs[g * 2]))
+                        gate.input1 = inputs[g * 2];
+                    if (canUseInput(g, 1, inputs[g * 2 + 1]))
+                        gate.input2 = inputs[g * 2 + 1];
+                }
+
+                m_logEnabled = mainNode->getBoolAttribute("decisionLog", false);
+                m_traceEnabled = mainNode->getBoolAttribute("slowestTrace", false);
+                setNumThreads(mainNode->getIntAttribute("threads", 1));
+                setControlPort(mainNode->getIntAttribute("controlPort", 0));
 
                 editor->updateSettings();
             }
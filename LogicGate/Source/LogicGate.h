@@ -36,6 +36,12 @@
 #define __LOGICGATE_H_A8BF66D6__
 
 #include <ProcessorHeaders.h>
+#include <atomic>
+#include "GateBank.h"
+#include "CommandQueue.h"
+#include "ProcessWatchdog.h"
+
+class ControlServer;
 
 using namespace std;
 
@@ -48,6 +54,67 @@ struct EventSources
     unsigned int eventIndex;
     unsigned int sourceId;
     unsigned int channel;
+    unsigned int subProcessor;
+    float sampleRate;
+    /** Index of the source's stream, filled in by LogicGate::addEventSource */
+    int stream;
+};
+
+/**
+ * @brief The StreamClock struct converts the timestamps of one input stream
+ * into the sample clock of the processor's own stream. The scale is fixed by
+ * the two sample rates, the offset is refreshed once per buffer from the
+ * streams' block start timestamps. Event-only streams have no blocks, their
+ * offset is anchored on an edge that falls outside the buffer it arrives in.
+ */
+struct StreamClock
+{
+    unsigned int sourceId;
+    unsigned int subProcessor;
+    float sampleRate;
+    double scale;
+    /** Includes +0.5 so that truncating in toOutput() rounds to the nearest sample */
+    double offset;
+    /** No samples in the current buffer */
+    bool eventOnly;
+
+    int64 toOutput(int64 timestamp) const { return static_cast<int64>(timestamp * scale + offset); }
+};
+
+/**
+ * @brief The BufferEdge struct holds one TTL edge of the current buffer,
+ * converted to the output clock, until the buffer's edges are sorted
+ */
+struct BufferEdge
+{
+    int64 timestamp;
+    int source;
+    int state;
+    int sourceId;
+    int channel;
+    /** Already waited for one buffer, fed with the next one at the latest */
+    bool held;
+};
+
+/**
+ * @brief The GateSettings struct holds the settings of one gate as shown in the
+ * editor. Inputs index the sources array, -1 is unconnected and
+ * GateBank::gateInput(g) reads the output of gate g. An output channel of -1
+ * keeps the gate internal, it only feeds other gates.
+ */
+struct GateSettings
+{
+    GateSettings();
+
+    int input1;
+    int input2;
+    bool input1gate;
+    bool input2gate;
+    int logicOp;
+    int outputChan;
+    int window;
+    int duration;
+    bool immediate;
 };
 
 /**
@@ -56,7 +123,8 @@ struct EventSources
 
     @see GenericProcessor, LogicGateEditor, LogicGateCanvas, PulsePal
 */
-class LogicGate : public GenericProcessor
+class LogicGate : public GenericProcessor,
+        public GateEngine::Listener
 {
 public:
     /** The class constructor, used to connect to PulsePal initialize any members. */
@@ -75,11 +143,14 @@ public:
     AudioProcessorEditor* createEditor() override;
     void process (AudioSampleBuffer& buffer) override;
     void handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum) override;
+    bool enable() override;
+    bool disable() override;
     void saveCustomParametersToXml(XmlElement *parentElement);
     void loadCustomParametersFromXml();
 
     /**
-     * @brief addEventSource adds a TTLevent source to the sources array
+     * @brief addEventSource adds a TTLevent source to the sources array, and its
+     * stream to the streams array if it is the first source of that stream
      * @param s: new source to add to the sources array
      */
     void addEventSource(EventSources s);
@@ -88,49 +159,165 @@ public:
      */
     void clearEventSources();
 
-    void setInput1(int i1);
-    void setInput2(int i2);
-    void setGate1(bool set);
-    void setGate2(bool set);
-    void setLogicOp(int op);
-    void setOutput(int out);
-    void setWindow(int win);
-    void setTtlDuration(int dur);
-
-    int getInput1();
-    int getInput2();
-    bool getGate1();
-    bool getGate2();
-    int getLogicOp();
-    int getOutput();
-    int getWindow();
-    int getTtlDuration();
+    /**
+     * @brief The processor holds a bank of gates evaluated within each buffer,
+     * a gate can read the output of any other gate as long as there is no loop.
+     * Gates can only be added or removed while acquisition is stopped.
+     */
+    int getNumGates();
+    /** Adds a gate with default settings and returns its index */
+    int addGate();
+    /** Removes a gate, inputs reading it are disconnected. The last gate is kept. */
+    void removeGate(int gate);
+    /**
+     * @brief canUseInput checks that connecting input to a gate would not close a loop
+     * @param slot: 0 for A, 1 for B
+     */
+    bool canUseInput(int gate, int slot, int input);
+
+    /**
+     * Gate setters return false, and leave the setting unchanged, if the change
+     * could not be handed to the audio thread during acquisition.
+     */
+    bool setInput1(int gate, int i1);
+    bool setInput2(int gate, int i2);
+    bool setGate1(int gate, bool set);
+    bool setGate2(int gate, bool set);
+    bool setLogicOp(int gate, int op);
+    bool setOutput(int gate, int out);
+    bool setWindow(int gate, int win);
+    bool setTtlDuration(int gate, int dur);
+    bool setImmediate(int gate, bool set);
+    /**
+     * @brief setLogEnabled writes every edge and decision to a binary log in the
+     * user's documents folder from the next acquisition on (see DecisionLog)
+     */
+    void setLogEnabled(bool set);
+    /**
+     * @brief setControlPort starts accepting set/get commands on a loopback TCP
+     * port (see ControlServer), 0 turns the endpoint off
+     */
+    void setControlPort(int port);
+    /**
+     * @brief setTraceEnabled writes the slowest buffers of each acquisition to a
+     * CSV file in the user's documents folder when acquisition stops
+     */
+    void setTraceEnabled(bool set);
+    /**
+     * @brief setNumThreads settles independent groups of gates on worker threads,
+     * once per buffer, from the next acquisition on; 1 keeps everything on the
+     * audio thread. With more than one thread, a buffer's decisions are logged
+     * after its input edges.
+     */
+    void setNumThreads(int threads);
+
+    int getInput1(int gate);
+    int getInput2(int gate);
+    bool getGate1(int gate);
+    bool getGate2(int gate);
+    int getLogicOp(int gate);
+    int getOutput(int gate);
+    int getWindow(int gate);
+    int getTtlDuration(int gate);
+    bool getImmediate(int gate);
+    bool getLogEnabled();
+    int getControlPort();
+    bool getTraceEnabled();
+    int getNumThreads();
+    int getNumSources();
+
+    /**
+     * @brief DELAY edges dropped because more than the delay line capacity were
+     * pending at once, and the largest number ever pending
+     */
+    uint64 getDelayOverflows(int gate);
+    int getDelayHighWaterMark(int gate);
+
+    /**
+     * @brief getActivity returns the event, trigger, expired window and drop
+     * counts of a gate since acquisition started. Safe to read from the message thread.
+     */
+    const ActivityCounters& getActivity(int gate);
+
+    /**
+     * @brief getWatchdog returns the timing of process() against the real-time
+     * budget of each buffer. Safe to read from the message thread.
+     */
+    const ProcessWatchdog& getWatchdog();
 
 protected:
     void createEventChannels() override;
 
 private:
-    int m_input1;
-    int m_input2;
-    bool m_input1gate;
-    bool m_input2gate;
-    int m_logicOp;
-    int m_outputChan;
-    int m_window;
+    // Settings as shown in the editor, owned by the message thread
+    Array<GateSettings> m_gates;
     Array<EventSources> m_sources;
+    Array<StreamClock> m_streams;
+
+    // Sample clock of the current buffer, in the processor's own stream
+    int64 m_bufferStart;
+    int m_bufferSamples;
+    /** Set by enable(), the bank's clock restarts at the first buffer */
+    bool m_firstBuffer;
 
-    // Time
-    float m_timePassed;
-    int64 m_previousTime;
-    int64 m_currentTime;
-    int64 m_timeFromTrigger;
-    int m_pulseDuration;
+    // Edges of the current buffer, fed to the bank in timestamp order once all are in.
+    // Edges converted past the end of the buffer wait for the next one, no longer; later
+    // ones are moved to its last sample. Reserved for BUFFER_EDGES edges, a busier buffer
+    // grows it once
+    std::vector<BufferEdge> m_bufferEdges;
+    static const int BUFFER_EDGES = 4096;
 
-    // Conditions
-    bool A;
-    bool B;
+    // Decisions. The audio thread works on its own copy of the settings, changes
+    // made during acquisition are queued and applied at the next buffer boundary;
+    // input changes arrive as a whole new wiring
+    GateBank m_bank;
+    int m_numThreads;
+    Array<GateSettings> m_audioGates;
+    CommandQueue m_commands;
+    bool m_acquiring;
 
-    void triggerEvent();
+    /** A wiring built on the message thread, handed to the audio thread by pointer */
+    struct PendingWiring
+    {
+        std::unique_ptr<GateBank::Wiring> wiring;
+        PendingWiring* next;
+    };
+    std::atomic<PendingWiring*> m_pendingWiring;
+    /** Wirings the audio thread replaced, freed by the message thread */
+    std::atomic<PendingWiring*> m_retiredWirings;
+
+    // Optional decision log, m_logging is only changed while acquisition is stopped
+    DecisionLog m_log;
+    bool m_logEnabled;
+    bool m_logging;
+
+    // Time spent per buffer, with an optional trace of the slowest ones
+    ProcessWatchdog m_watchdog;
+    bool m_traceEnabled;
+
+    // Optional loopback control endpoint
+    int m_controlPort;
+    ScopedPointer<ControlServer> m_controlServer;
+
+    /**
+     * Changes a setting of a gate, and of the audio thread's copy during acquisition.
+     * Returns false without changing anything if the command queue is full.
+     */
+    bool setParameter(int gate, int param, int value);
+    /** Converts settings to the bank's gates, times in samples */
+    void makeBankGates(const Array<GateSettings>& settings, std::vector<GateBank::Gate>& gates);
+    GateConfig makeGateConfig(const GateSettings& settings);
+    /** Builds the wiring of m_gates and hands it to the audio thread */
+    void publishWiring();
+    /** Frees the wirings given up by the audio thread, and one it has not taken yet if discard is set */
+    void freeWirings(bool discard);
+    /** Anchors every input stream's clock to the start of the current buffer */
+    void updateStreamClocks();
+    /** Feeds the collected edges before end to the bank and the log, in timestamp order */
+    void feedEdges(int64 end);
+    /** Index of the source a TTL event belongs to, -1 if it is not in the input lists */
+    int findSource(int eventIndex, int sourceId, int channel);
+    void gateOutput(int64_t timestamp, bool on, int outputChan) override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LogicGate);
 };
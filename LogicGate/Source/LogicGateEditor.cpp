@@ -26,13 +26,14 @@
 
 LogicGateEditor::LogicGateEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors=true)
     : GenericEditor(parentNode, useDefaultParameterEditors)
+    , m_gateSelected(0)
     , m_input1Selected(1)
     , m_input2Selected(1)
     , m_logicOp(1)
     , m_outputChan(1)
 {
     tabText = "LogicGate";
-    desiredWidth = 300;
+    desiredWidth = 440;
 
     input1Selector = new ComboBox();
     input1Selector->setBounds(20,30,160,20);
@@ -69,6 +70,7 @@ LogicGateEditor::LogicGateEditor(GenericProcessor* parentNode, bool useDefaultPa
 
     for (int i=1; i<9; i++)
         outputChans->addItem(String(i), i);
+    outputChans->addItem("None", NO_OUTPUT_ITEM);
 
     outputChans->setSelectedId(m_outputChan, dontSendNotification);
     addAndMakeVisible(outputChans);
@@ -90,6 +92,15 @@ LogicGateEditor::LogicGateEditor(GenericProcessor* parentNode, bool useDefaultPa
 
     addAndMakeVisible(gate2Button);
 
+    immediateButton = new UtilityButton("IMMED", titleFont);
+    immediateButton->addListener(this);
+    immediateButton->setRadius(3.0f);
+    immediateButton->setBounds(220,72,60,15);
+    immediateButton->setClickingTogglesState(true);
+    immediateButton->setTooltip("OR and XOR fire on the deciding edge instead of at the end of the window");
+
+    addChildComponent(immediateButton);
+
     input1Label = new Label ("i1", "A");
     input1Label->setBounds (0,30,20,20);
     addAndMakeVisible (input1Label);
@@ -131,6 +142,65 @@ LogicGateEditor::LogicGateEditor(GenericProcessor* parentNode, bool useDefaultPa
     durationEditLabel->setEditable (true);
     durationEditLabel->addListener (this);
     addAndMakeVisible (durationEditLabel);
+
+    activityDisplay = new LogicGateActivityDisplay((LogicGate*) parentNode);
+    activityDisplay->setBounds (290,25,85,90);
+    addAndMakeVisible (activityDisplay);
+
+    logButton = new UtilityButton("LOG", titleFont);
+    logButton->addListener(this);
+    logButton->setRadius(3.0f);
+    logButton->setBounds(290,115,40,15);
+    logButton->setClickingTogglesState(true);
+    logButton->setTooltip("Write every edge and decision to a binary log in the documents folder");
+    addAndMakeVisible(logButton);
+
+    traceButton = new UtilityButton("TRACE", titleFont);
+    traceButton->addListener(this);
+    traceButton->setRadius(3.0f);
+    traceButton->setBounds(335,115,42,15);
+    traceButton->setClickingTogglesState(true);
+    traceButton->setTooltip("Write the slowest buffers of each acquisition to a CSV file in the documents folder");
+    addAndMakeVisible(traceButton);
+
+    gateLabel = new Label ("gate", "GATE");
+    gateLabel->setBounds (380,25,55,20);
+    addAndMakeVisible (gateLabel);
+
+    gateSelector = new ComboBox("Gate");
+    gateSelector->setBounds(380,45,55,20);
+    gateSelector->addListener(this);
+    gateSelector->setTooltip("Gates of this processor, each can read the outputs of the others");
+    addAndMakeVisible(gateSelector);
+    fillGateSelector();
+
+    addGateButton = new UtilityButton("+", titleFont);
+    addGateButton->addListener(this);
+    addGateButton->setRadius(3.0f);
+    addGateButton->setBounds(380,72,25,15);
+    addGateButton->setTooltip("Add a gate");
+    addAndMakeVisible(addGateButton);
+
+    removeGateButton = new UtilityButton("-", titleFont);
+    removeGateButton->addListener(this);
+    removeGateButton->setRadius(3.0f);
+    removeGateButton->setBounds(410,72,25,15);
+    removeGateButton->setTooltip("Remove the selected gate");
+    addAndMakeVisible(removeGateButton);
+
+    portLabel = new Label ("port", "PORT");
+    portLabel->setBounds (380,92,55,18);
+    addAndMakeVisible (portLabel);
+
+    portEditLabel = new Label ("port_edit", "0");
+    portEditLabel->setBounds (380,110,55,18);
+    portEditLabel->setFont (Font ("Default", 13, Font::plain));
+    portEditLabel->setColour (Label::textColourId, Colours::white);
+    portEditLabel->setColour (Label::backgroundColourId, Colours::grey);
+    portEditLabel->setEditable (true);
+    portEditLabel->addListener (this);
+    portEditLabel->setTooltip ("Loopback TCP port accepting set/get commands, 0 is off");
+    addAndMakeVisible (portEditLabel);
 }
 
 
@@ -144,12 +214,7 @@ void LogicGateEditor::updateSettings()
     String name;
     LogicGate* processor = (LogicGate*) getProcessor();
     processor->clearEventSources();
-    input1Selector->clear();
-    input2Selector->clear();
-    input1Selector->addItem("Select", 1);
-    input2Selector->addItem("Select", 1);
-    int nextItem1 = 2;
-    int nextItem2 = 2;
+    m_sourceNames.clear();
     int nEvents = processor->getTotalEventChannels();
     for (int i = 0; i < nEvents; i++)
     {
@@ -170,93 +235,188 @@ void LogicGateEditor::updateSettings()
             {
                 s.eventIndex = event->getSourceIndex();
                 s.sourceId = event->getSourceNodeID();
+                s.subProcessor = event->getSubProcessorIdx();
+                s.sampleRate = event->getSampleRate();
                 int nChans = event->getNumChannels();
                 for (int c = 0; c < nChans; c++)
                 {
                     s.channel = c;
                     name = event->getSourceName() + " " + String(event->getSourceIndex() + n + 1) + " (TTL" + String(c+1) + ")";
                     processor->addEventSource(s);
-                    input1Selector->addItem(name, nextItem1++);
-                    input2Selector->addItem(name, nextItem2++);
+                    m_sourceNames.add(name);
                 }
             }
         }
     }
 
     LogicGate* p = (LogicGate*) getProcessor();
-    m_input1Selected = p->getInput1() + 2; // first is select
-    m_input2Selected = p->getInput2() + 2;
-    m_logicOp = p->getLogicOp() + 1;
-    m_outputChan = p->getOutput() + 1;
+    if (p->getLogEnabled() != logButton->getToggleState())
+        logButton->triggerClick();
+    if (p->getTraceEnabled() != traceButton->getToggleState())
+        traceButton->triggerClick();
+    portEditLabel->setText(String(p->getControlPort()), dontSendNotification);
+
+    if (m_gateSelected >= p->getNumGates())
+        m_gateSelected = p->getNumGates() - 1;
+    fillGateSelector();
+    showGate(m_gateSelected);
+}
+
+void LogicGateEditor::fillGateSelector()
+{
+    LogicGate* processor = (LogicGate*) getProcessor();
+    gateSelector->clear(dontSendNotification);
+    for (int g = 0; g < processor->getNumGates(); g++)
+        gateSelector->addItem(String(g + 1), g + 1);
+    gateSelector->setSelectedId(m_gateSelected + 1, dontSendNotification);
+}
+
+void LogicGateEditor::fillInputSelectors()
+{
+    LogicGate* processor = (LogicGate*) getProcessor();
+    input1Selector->clear(dontSendNotification);
+    input2Selector->clear(dontSendNotification);
+    input1Selector->addItem("Select", 1);
+    input2Selector->addItem("Select", 1);
+
+    for (int i = 0; i < m_sourceNames.size(); i++)
+    {
+        input1Selector->addItem(m_sourceNames[i], inputToItemId(i));
+        input2Selector->addItem(m_sourceNames[i], inputToItemId(i));
+    }
+
+    for (int g = 0; g < processor->getNumGates(); g++)
+    {
+        if (g == m_gateSelected)
+            continue;
+        const int input = GateBank::gateInput(g);
+        input1Selector->addItem("Gate " + String(g + 1), inputToItemId(input));
+        input2Selector->addItem("Gate " + String(g + 1), inputToItemId(input));
+    }
+}
+
+int LogicGateEditor::inputToItemId(int input)
+{
+    if (GateBank::isGateInput(input))
+        return GATE_ITEM_OFFSET + GateBank::inputGate(input);
+    return input + 2; // first is select
+}
+
+int LogicGateEditor::itemIdToInput(int itemId)
+{
+    if (itemId >= GATE_ITEM_OFFSET)
+        return GateBank::gateInput(itemId - GATE_ITEM_OFFSET);
+    return itemId - 2;
+}
+
+void LogicGateEditor::showGate(int gate)
+{
+    LogicGate* p = (LogicGate*) getProcessor();
+    m_gateSelected = gate;
+    fillInputSelectors();
 
-    windowEditLabel->setText(String(p->getWindow()), dontSendNotification);
-    durationEditLabel->setText(String(p->getTtlDuration()), dontSendNotification);
+    m_input1Selected = inputToItemId(p->getInput1(gate));
+    m_input2Selected = inputToItemId(p->getInput2(gate));
+    m_logicOp = p->getLogicOp(gate) + 1;
+    m_outputChan = p->getOutput(gate) < 0 ? NO_OUTPUT_ITEM : p->getOutput(gate) + 1;
 
-    if (p->getGate1())
-        if (!gate1Button->getState())
-            gate1Button->triggerClick();
-    if (p->getGate2())
-        if (!gate2Button->getState())
-            gate2Button->triggerClick();
+    windowEditLabel->setText(String(p->getWindow(gate)), dontSendNotification);
+    durationEditLabel->setText(String(p->getTtlDuration(gate)), dontSendNotification);
 
-    if (m_input1Selected > input1Selector->getNumItems())
-        m_input1Selected = input1Selector->getNumItems();
-    input1Selector->setSelectedId(m_input1Selected);
+    gate1Button->setToggleState(p->getGate1(gate), dontSendNotification);
+    gate2Button->setToggleState(p->getGate2(gate), dontSendNotification);
+    immediateButton->setToggleState(p->getImmediate(gate), dontSendNotification);
+
+    // sources that went away are disconnected
+    if (input1Selector->indexOfItemId(m_input1Selected) < 0)
+    {
+        m_input1Selected = 1;
+        p->setInput1(gate, GateBank::NO_INPUT);
+    }
+    input1Selector->setSelectedId(m_input1Selected, dontSendNotification);
 
-    if (m_input2Selected > input2Selector->getNumItems())
-        m_input2Selected = input2Selector->getNumItems();
-    input2Selector->setSelectedId(m_input2Selected);
+    if (input2Selector->indexOfItemId(m_input2Selected) < 0)
+    {
+        m_input2Selected = 1;
+        p->setInput2(gate, GateBank::NO_INPUT);
+    }
+    input2Selector->setSelectedId(m_input2Selected, dontSendNotification);
 
     if (m_logicOp > logicSelector->getNumItems())
         m_logicOp = logicSelector->getNumItems();
-    logicSelector->setSelectedId(m_logicOp);
+    logicSelector->setSelectedId(m_logicOp, dontSendNotification);
+    updateOperatorControls();
 
-    if (m_outputChan > outputChans->getNumItems())
-        m_outputChan = outputChans->getNumItems();
-    outputChans->setSelectedId(m_outputChan);
+    outputChans->setSelectedId(m_outputChan, dontSendNotification);
+
+    activityDisplay->setGate(gate);
+}
+
+void LogicGateEditor::refreshGate()
+{
+    LogicGate* p = (LogicGate*) getProcessor();
+    logButton->setToggleState(p->getLogEnabled(), dontSendNotification);
+    traceButton->setToggleState(p->getTraceEnabled(), dontSendNotification);
+    showGate(m_gateSelected);
+}
+
+void LogicGateEditor::updateOperatorControls()
+{
+    const int op = m_logicOp - 1;
+
+    // DELAY only has one input
+    input2Selector->setVisible(op != 3);
+    input2Label->setVisible(op != 3);
+    gate2Button->setVisible(op != 3);
+
+    // immediate firing only applies to OR and XOR
+    immediateButton->setVisible(op == 1 || op == 2);
 }
 
 void LogicGateEditor::comboBoxChanged(ComboBox* comboBoxThatHasChanged)
 {
     LogicGate* processor = (LogicGate*) getProcessor();
-    if (comboBoxThatHasChanged == input1Selector)
+    if (comboBoxThatHasChanged == input1Selector || comboBoxThatHasChanged == input2Selector)
     {
-        processor->setInput1(comboBoxThatHasChanged->getSelectedId() - 2);
-        if (comboBoxThatHasChanged->getSelectedId() > 0)
-            m_input1Selected = comboBoxThatHasChanged->getSelectedId();
+        const int slot = comboBoxThatHasChanged == input1Selector ? 0 : 1;
+        int& selected = slot == 0 ? m_input1Selected : m_input2Selected;
+        const int itemId = comboBoxThatHasChanged->getSelectedId() > 0 ? comboBoxThatHasChanged->getSelectedId() : 1;
+        const int input = itemIdToInput(itemId);
+
+        if (!processor->canUseInput(m_gateSelected, slot, input))
+        {
+            CoreServices::sendStatusMessage("Logic Gate: gate " + String(m_gateSelected + 1) + " would read its own output");
+            comboBoxThatHasChanged->setSelectedId(selected, dontSendNotification);
+            return;
+        }
+
+        const bool applied = slot == 0 ? processor->setInput1(m_gateSelected, input)
+                                       : processor->setInput2(m_gateSelected, input);
+        if (applied)
+            selected = itemId;
         else
-            m_input1Selected = 1;
+            comboBoxThatHasChanged->setSelectedId(selected, dontSendNotification);
     }
-    else if (comboBoxThatHasChanged == input2Selector)
+    else if (comboBoxThatHasChanged == gateSelector)
     {
-        processor->setInput2(comboBoxThatHasChanged->getSelectedId() - 2);
         if (comboBoxThatHasChanged->getSelectedId() > 0)
-            m_input2Selected = comboBoxThatHasChanged->getSelectedId();
-        else
-            m_input2Selected = 1;
+            showGate(comboBoxThatHasChanged->getSelectedId() - 1);
     }
     else if (comboBoxThatHasChanged == logicSelector)
     {
-        m_logicOp = comboBoxThatHasChanged->getSelectedId() - 1;
-        processor->setLogicOp(m_logicOp);
-
-        if (m_logicOp == 3)
-        {
-            input2Selector->setVisible(false);
-            input2Label->setVisible(false);
-            gate2Button->setVisible(false);
-        }
+        if (processor->setLogicOp(m_gateSelected, comboBoxThatHasChanged->getSelectedId() - 1))
+            m_logicOp = comboBoxThatHasChanged->getSelectedId();
         else
-        {
-            input2Selector->setVisible(true);
-            input2Label->setVisible(true);
-            gate2Button->setVisible(true);
-        }
+            comboBoxThatHasChanged->setSelectedId(m_logicOp, dontSendNotification);
+        updateOperatorControls();
     }
     else if (comboBoxThatHasChanged == outputChans)
     {
-        m_outputChan = comboBoxThatHasChanged->getSelectedId() - 1;
-        processor->setOutput((int) m_outputChan);
+        const int itemId = comboBoxThatHasChanged->getSelectedId();
+        if (processor->setOutput(m_gateSelected, itemId == NO_OUTPUT_ITEM ? -1 : itemId - 1))
+            m_outputChan = itemId;
+        else
+            comboBoxThatHasChanged->setSelectedId(m_outputChan, dontSendNotification);
     }
 }
 
@@ -269,7 +429,8 @@ void LogicGateEditor::labelTextChanged (Label* labelThatHasChanged)
         if (value>=0)
         {
             LogicGate* processor = (LogicGate*) getProcessor();
-            processor->setWindow(value);
+            if (!processor->setWindow(m_gateSelected, value))
+                value = processor->getWindow(m_gateSelected);
             labelThatHasChanged->setText(String(value), dontSendNotification);
         }
         else
@@ -285,7 +446,8 @@ void LogicGateEditor::labelTextChanged (Label* labelThatHasChanged)
         if (value>=0)
         {
             LogicGate* processor = (LogicGate*) getProcessor();
-            processor->setTtlDuration(value);
+            if (!processor->setTtlDuration(m_gateSelected, value))
+                value = processor->getTtlDuration(m_gateSelected);
             labelThatHasChanged->setText(String(value), dontSendNotification);
         }
         else
@@ -294,6 +456,16 @@ void LogicGateEditor::labelTextChanged (Label* labelThatHasChanged)
             labelThatHasChanged->setText("", dontSendNotification);
         }
     }
+    else if (labelThatHasChanged == portEditLabel)
+    {
+        LogicGate* processor = (LogicGate*) getProcessor();
+        int value = labelThatHasChanged->getText().getIntValue();
+        if (value >= 0 && value < 65536)
+            processor->setControlPort(value);
+        else
+            CoreServices::sendStatusMessage("Port must be between 0 and 65535");
+        labelThatHasChanged->setText(String(processor->getControlPort()), dontSendNotification);
+    }
 
 }
 
@@ -302,21 +474,60 @@ void LogicGateEditor::buttonEvent(Button* button)
     LogicGate* processor = (LogicGate*) getProcessor();
     if (button == gate1Button)
     {
-        if (button->getToggleState()==true)
-            processor->setGate1(true);
-        else
-            processor->setGate1(false);
+        if (!processor->setGate1(m_gateSelected, button->getToggleState()))
+            button->setToggleState(processor->getGate1(m_gateSelected), dontSendNotification);
     }
     else if (button == gate2Button)
     {
-        if (button->getToggleState()==true)
-            processor->setGate2(true);
-        else
-            processor->setGate2(false);
+        if (!processor->setGate2(m_gateSelected, button->getToggleState()))
+            button->setToggleState(processor->getGate2(m_gateSelected), dontSendNotification);
+    }
+    else if (button == immediateButton)
+    {
+        if (!processor->setImmediate(m_gateSelected, button->getToggleState()))
+            button->setToggleState(processor->getImmediate(m_gateSelected), dontSendNotification);
+    }
+    else if (button == logButton)
+    {
+        processor->setLogEnabled(button->getToggleState());
+    }
+    else if (button == traceButton)
+    {
+        processor->setTraceEnabled(button->getToggleState());
+    }
+    else if (button == addGateButton)
+    {
+        m_gateSelected = processor->addGate();
+        fillGateSelector();
+        showGate(m_gateSelected);
+    }
+    else if (button == removeGateButton)
+    {
+        processor->removeGate(m_gateSelected);
+        m_gateSelected = jmin(m_gateSelected, processor->getNumGates() - 1);
+        fillGateSelector();
+        showGate(m_gateSelected);
     }
 
 }
 
+void LogicGateEditor::startAcquisition()
+{
+    GenericEditor::startAcquisition();
+
+    // the gate bank is only resized while stopped
+    addGateButton->setEnabled(false);
+    removeGateButton->setEnabled(false);
+}
+
+void LogicGateEditor::stopAcquisition()
+{
+    GenericEditor::stopAcquisition();
+
+    addGateButton->setEnabled(true);
+    removeGateButton->setEnabled(true);
+}
+
 void LogicGateEditor::saveCustomParameters(XmlElement* xml)
 {
 
@@ -327,3 +538,80 @@ void LogicGateEditor::loadCustomParameters(XmlElement* xml)
 {
 
 }
+
+
+LogicGateActivityDisplay::LogicGateActivityDisplay(LogicGate* processor)
+    : m_processor(processor),
+      m_gate(0)
+{
+    for (int i = 0; i < NUM_COUNTS; i++)
+        m_counts[i] = 0;
+
+    startTimerHz(ACTIVITY_REFRESH_HZ);
+}
+
+LogicGateActivityDisplay::~LogicGateActivityDisplay()
+{
+    stopTimer();
+}
+
+void LogicGateActivityDisplay::setGate(int gate)
+{
+    m_gate = gate;
+    timerCallback();
+}
+
+void LogicGateActivityDisplay::timerCallback()
+{
+    const ActivityCounters& activity = m_processor->getActivity(m_gate);
+    uint64 counts[NUM_COUNTS];
+    counts[COUNT_A] = ActivityCounters::read(activity.inputEvents[0]);
+    counts[COUNT_B] = ActivityCounters::read(activity.inputEvents[1]);
+    counts[COUNT_TRIGGERS] = ActivityCounters::read(activity.triggers);
+    counts[COUNT_EXPIRED] = ActivityCounters::read(activity.expiredWindows);
+    counts[COUNT_DROPS] = ActivityCounters::read(activity.drops) + m_processor->getDelayOverflows(m_gate);
+
+    const ProcessWatchdog& watchdog = m_processor->getWatchdog();
+    counts[COUNT_LOAD_P99] = watchdog.getLoadPercentile(0.99);
+    counts[COUNT_LOAD_MAX] = uint64(watchdog.getWorstLoad());
+    counts[COUNT_OVERRUNS] = watchdog.getOverruns();
+
+    bool changed = false;
+    for (int i = 0; i < NUM_COUNTS; i++)
+    {
+        if (counts[i] != m_counts[i])
+        {
+            m_counts[i] = counts[i];
+            changed = true;
+        }
+    }
+
+    if (changed)
+        repaint();
+}
+
+void LogicGateActivityDisplay::paint(Graphics& g)
+{
+    // the load row shows the 99th percentile and the worst buffer, as a percent of the budget
+    static const int NUM_ROWS = 7;
+    static const char* const names[NUM_ROWS] = { "A", "B", "TRIG", "EXP", "DROP", "LOAD", "OVR" };
+    const String values[NUM_ROWS] = {
+        String(m_counts[COUNT_A]),
+        String(m_counts[COUNT_B]),
+        String(m_counts[COUNT_TRIGGERS]),
+        String(m_counts[COUNT_EXPIRED]),
+        String(m_counts[COUNT_DROPS]),
+        String(m_counts[COUNT_LOAD_P99]) + "/" + String(m_counts[COUNT_LOAD_MAX]) + "%",
+        String(m_counts[COUNT_OVERRUNS])
+    };
+
+    g.setFont(Font("Default", 12, Font::plain));
+    for (int i = 0; i < NUM_ROWS; i++)
+    {
+        const int y = i * 12;
+        g.setColour(Colours::darkgrey);
+        g.drawText(names[i], 0, y, 35, 12, Justification::centredLeft, false);
+        g.setColour(Colours::black);
+        g.drawText(values[i], 35, y, getWidth() - 35, 12, Justification::centredLeft, true);
+    }
+}
@@ -28,6 +28,50 @@
 #include "LogicGate.h"
 
 #define DEF_WINDOW 50
+#define ACTIVITY_REFRESH_HZ 4
+#define GATE_ITEM_OFFSET 1000
+#define NO_OUTPUT_ITEM 9
+
+/**
+
+  Shows the activity counters of one LogicGate gate. They are sampled a few
+  times per second and the component only repaints when one of them changed,
+  so the audio thread never triggers any drawing.
+
+  @see LogicGate, ActivityCounters
+
+*/
+class LogicGateActivityDisplay : public Component,
+        public Timer
+{
+public:
+    LogicGateActivityDisplay(LogicGate* processor);
+    ~LogicGateActivityDisplay();
+    void paint(Graphics& g) override;
+    void timerCallback() override;
+    void setGate(int gate);
+
+private:
+    enum
+    {
+        COUNT_A,
+        COUNT_B,
+        COUNT_TRIGGERS,
+        COUNT_EXPIRED,
+        COUNT_DROPS,
+        COUNT_LOAD_P99,
+        COUNT_LOAD_MAX,
+        COUNT_OVERRUNS,
+        NUM_COUNTS
+    };
+
+    LogicGate* m_processor;
+    int m_gate;
+    uint64 m_counts[NUM_COUNTS];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LogicGateActivityDisplay);
+};
+
 /**
 
   User interface for the LogicGate.
@@ -47,21 +91,30 @@ public:
     virtual void labelTextChanged (Label* labelThatHasChanged) override;
     void buttonEvent(Button* button);
     void comboBoxChanged(ComboBox* c);
+    void startAcquisition() override;
+    void stopAcquisition() override;
+    /** Shows settings changed from outside the editor, e.g. by the control endpoint */
+    void refreshGate();
 
 
 private:
     Array<String> logic_op;
 
+    StringArray m_sourceNames;
+
+    int m_gateSelected;
     int m_input1Selected;
     int m_input2Selected;
     int m_logicOp;
     int m_outputChan;
 
+    ScopedPointer<ComboBox> gateSelector;
     ScopedPointer<ComboBox> logicSelector;
     ScopedPointer<ComboBox> input1Selector;
     ScopedPointer<ComboBox> input2Selector;
     ScopedPointer<ComboBox> outputChans;
 
+    ScopedPointer<Label> gateLabel;
     ScopedPointer<Label> input1Label;
     ScopedPointer<Label> input2Label;
     ScopedPointer<Label> logicLabel;
@@ -73,8 +126,27 @@ private:
     ScopedPointer<Label> durationLabel;
     ScopedPointer<Label> durationEditLabel;
 
+    ScopedPointer<Label> portLabel;
+    ScopedPointer<Label> portEditLabel;
+
     ScopedPointer<UtilityButton> gate1Button;
     ScopedPointer<UtilityButton> gate2Button;
+    ScopedPointer<UtilityButton> immediateButton;
+    ScopedPointer<UtilityButton> logButton;
+    ScopedPointer<UtilityButton> traceButton;
+    ScopedPointer<UtilityButton> addGateButton;
+    ScopedPointer<UtilityButton> removeGateButton;
+
+    ScopedPointer<LogicGateActivityDisplay> activityDisplay;
+
+    /** Shows the settings of a gate in the controls */
+    void showGate(int gate);
+    /** Lists the sources and the outputs of the other gates as inputs of the selected gate */
+    void fillInputSelectors();
+    void fillGateSelector();
+    void updateOperatorControls();
+    int inputToItemId(int input);
+    int itemIdToInput(int itemId);
 
     void saveCustomParameters(XmlElement* xml);
     void loadCustomParameters(XmlElement* xml);
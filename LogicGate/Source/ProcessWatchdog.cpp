@@ -0,0 +1,167 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProcessWatchdog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+
+// long enough for a 0.1% frequency estimate from the steady clock
+static const int CALIBRATION_MS = 5;
+
+ProcessWatchdog::ProcessWatchdog()
+    : m_ticksPerSecond(0)
+{
+    reset();
+}
+
+void ProcessWatchdog::calibrate()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const Clock::time_point clockStart = Clock::now();
+    const uint64_t counterStart = readCounter();
+    std::this_thread::sleep_for (std::chrono::milliseconds (CALIBRATION_MS));
+    const uint64_t counterEnd = readCounter();
+    const double seconds = std::chrono::duration<double> (Clock::now() - clockStart).count();
+
+    m_ticksPerSecond = seconds > 0 ? (counterEnd - counterStart) / seconds : 0;
+}
+
+void ProcessWatchdog::reset()
+{
+    m_buffers.store (0, std::memory_order_relaxed);
+    m_overruns.store (0, std::memory_order_relaxed);
+    m_worstPermille.store (0, std::memory_order_relaxed);
+    for (int i = 0; i < LOAD_BINS; i++)
+        m_loadHistogram[i].store (0, std::memory_order_relaxed);
+
+    m_eventTicks = 0;
+    m_numEvents = 0;
+    m_numSlowest = 0;
+    m_fastestOfSlowest = 0;
+}
+
+void ProcessWatchdog::endBuffer (uint64_t started, int64_t timestamp, int numSamples, double sampleRate)
+{
+    const uint64_t ticks = readCounter() - started;
+    const uint64_t eventTicks = m_eventTicks;
+    const int numEvents = m_numEvents;
+    m_eventTicks = 0;
+    m_numEvents = 0;
+
+    if (m_ticksPerSecond <= 0 || numSamples <= 0 || sampleRate <= 0)
+        return;
+
+    const uint64_t budgetTicks = uint64_t (m_ticksPerSecond * numSamples / sampleRate);
+    const uint64_t permille = budgetTicks > 0 ? ticks * 1000 / budgetTicks : 0;
+
+    // single writer: plain load and store, no read-modify-write
+    m_buffers.store (m_buffers.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ticks > budgetTicks)
+        m_overruns.store (m_overruns.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (permille > m_worstPermille.load (std::memory_order_relaxed))
+        m_worstPermille.store (uint32_t (permille < UINT32_MAX ? permille : UINT32_MAX), std::memory_order_relaxed);
+
+    std::atomic<uint64_t>& bin = m_loadHistogram[permille / 10 < uint64_t (LOAD_BINS) ? permille / 10 : LOAD_BINS - 1];
+    bin.store (bin.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // keep the slowest buffers relative to their budget
+    Buffer buffer = { timestamp, numSamples, numEvents, ticks, eventTicks, budgetTicks };
+    int slot = -1;
+    if (m_numSlowest < SLOWEST)
+    {
+        slot = m_numSlowest++;
+    }
+    else
+    {
+        const Buffer& fastest = m_slowest[m_fastestOfSlowest];
+        if (ticks * fastest.budgetTicks > fastest.ticks * budgetTicks)
+            slot = m_fastestOfSlowest;
+    }
+
+    if (slot >= 0)
+    {
+        m_slowest[slot] = buffer;
+        for (int i = 0; i < m_numSlowest; i++)
+        {
+            const Buffer& a = m_slowest[i];
+            const Buffer& b = m_slowest[m_fastestOfSlowest];
+            if (a.ticks * b.budgetTicks < b.ticks * a.budgetTicks)
+                m_fastestOfSlowest = i;
+        }
+    }
+}
+
+int ProcessWatchdog::getLoadPercentile (double fraction) const
+{
+    uint64_t counts[LOAD_BINS];
+    uint64_t total = 0;
+    for (int i = 0; i < LOAD_BINS; i++)
+    {
+        counts[i] = m_loadHistogram[i].load (std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0)
+        return 0;
+
+    const uint64_t target = uint64_t (fraction * total + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < LOAD_BINS; i++)
+    {
+        seen += counts[i];
+        if (seen >= target && seen > 0)
+            return i + 1;
+    }
+    return LOAD_BINS;
+}
+
+bool ProcessWatchdog::writeSlowest (const std::string& path) const
+{
+    FILE* file = fopen (path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    Buffer sorted[SLOWEST];
+    for (int i = 0; i < m_numSlowest; i++)
+        sorted[i] = m_slowest[i];
+    for (int i = 1; i < m_numSlowest; i++)
+        for (int j = i; j > 0 && sorted[j].ticks * sorted[j - 1].budgetTicks > sorted[j - 1].ticks * sorted[j].budgetTicks; j--)
+            std::swap (sorted[j], sorted[j - 1]);
+
+    const double usPerTick = m_ticksPerSecond > 0 ? 1e6 / m_ticksPerSecond : 0;
+    fprintf (file, "timestamp,samples,budget_us,elapsed_us,load_percent,events,events_us\n");
+    for (int i = 0; i < m_numSlowest; i++)
+    {
+        const Buffer& b = sorted[i];
+        fprintf (file, "%" PRId64 ",%d,%.1f,%.1f,%.1f,%d,%.1f\n", b.timestamp, b.numSamples,
+                 b.budgetTicks * usPerTick, b.ticks * usPerTick,
+                 b.budgetTicks > 0 ? 100.0 * b.ticks / b.budgetTicks : 0.0,
+                 b.numEvents, b.eventTicks * usPerTick);
+    }
+
+    fclose (file);
+    return true;
+}
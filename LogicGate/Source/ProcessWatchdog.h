@@ -0,0 +1,127 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __PROCESSWATCHDOG_H_7D3B92A0__
+#define __PROCESSWATCHDOG_H_7D3B92A0__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+    Times every buffer of LogicGate::process against its real-time budget.
+
+    The audio thread reads the CPU's cycle counter (TSC on x86, the virtual
+    counter on ARM64, a steady clock elsewhere) at the start and end of each
+    buffer, around each handled event and around feeding the edges to the
+    gates, and compares the buffer's time with its length in seconds. Statistics are kept in relaxed atomics with the audio
+    thread as the only writer, so the editor can read them at any time. The
+    slowest buffers are also kept, in memory only the audio thread touches,
+    to be written out once acquisition has stopped.
+*/
+class ProcessWatchdog
+{
+public:
+    /** Load histogram bins, in percent of the budget; the last bin collects everything above */
+    static const int LOAD_BINS = 256;
+    static const int SLOWEST = 16;
+
+    struct Buffer
+    {
+        int64_t timestamp;
+        int numSamples;
+        int numEvents;
+        uint64_t ticks;
+        uint64_t eventTicks;
+        uint64_t budgetTicks;
+    };
+
+    ProcessWatchdog();
+
+    /** Measures the counter frequency against the steady clock, sleeps a few ms. Message thread only. */
+    void calibrate();
+    bool isCalibrated() const { return m_ticksPerSecond > 0; }
+    double getTicksPerSecond() const { return m_ticksPerSecond; }
+
+    /** Clears the statistics and the slowest buffers while the audio thread is stopped. */
+    void reset();
+
+    static inline uint64_t readCounter();
+
+    /** Audio thread: time spent handling events, numEvents of them were received in it */
+    void addEventTicks (uint64_t ticks, int numEvents = 1) { m_eventTicks += ticks; m_numEvents += numEvents; }
+    /** Audio thread: closes a buffer that started at counter value started */
+    void endBuffer (uint64_t started, int64_t timestamp, int numSamples, double sampleRate);
+
+    uint64_t getBuffers() const { return m_buffers.load (std::memory_order_relaxed); }
+    uint64_t getOverruns() const { return m_overruns.load (std::memory_order_relaxed); }
+    /** Worst load seen, in percent of the budget */
+    double getWorstLoad() const { return m_worstPermille.load (std::memory_order_relaxed) / 10.0; }
+    /** Load that fraction (0-1) of the buffers stayed under, to the percent */
+    int getLoadPercentile (double fraction) const;
+
+    /** Writes the slowest buffers as CSV, slowest first. Only once the audio thread has stopped. */
+    bool writeSlowest (const std::string& path) const;
+
+private:
+    double m_ticksPerSecond;
+
+    std::atomic<uint64_t> m_buffers;
+    std::atomic<uint64_t> m_overruns;
+    std::atomic<uint32_t> m_worstPermille;
+    std::atomic<uint64_t> m_loadHistogram[LOAD_BINS];
+
+    // audio thread only
+    uint64_t m_eventTicks;
+    int m_numEvents;
+    Buffer m_slowest[SLOWEST];
+    int m_numSlowest;
+    int m_fastestOfSlowest;
+
+    ProcessWatchdog (const ProcessWatchdog&) = delete;
+    ProcessWatchdog& operator= (const ProcessWatchdog&) = delete;
+};
+
+#if defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+ #include <intrin.h>
+#elif defined (__x86_64__) || defined (__i386__)
+ #include <x86intrin.h>
+#elif !defined (__aarch64__)
+ #include <chrono>
+#endif
+
+inline uint64_t ProcessWatchdog::readCounter()
+{
+#if defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+    return __rdtsc();
+#elif defined (__x86_64__) || defined (__i386__)
+    return __rdtsc();
+#elif defined (__aarch64__)
+    uint64_t value;
+    asm volatile ("mrs %0, cntvct_el0" : "=r" (value));
+    return value;
+#else
+    return uint64_t (std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+#endif  // __PROCESSWATCHDOG_H_7D3B92A0__
@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SPSCRING_H_3A81D6C0__
+#define __SPSCRING_H_3A81D6C0__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+    Wait-free single-producer single-consumer ring.
+
+    One thread pushes, one thread pops, neither ever blocks; both may be the
+    same thread. Storage is allocated once in the constructor and the
+    capacity is rounded up to a power of two.
+
+    @see CommandQueue, DecisionLog, DelayLine
+*/
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing (int capacity)
+        : m_head(0),
+          m_tail(0)
+    {
+        uint64_t size = 1;
+        while (size < uint64_t (capacity))
+            size <<= 1;
+
+        m_items.resize (size);
+        m_mask = size - 1;
+    }
+
+    /** Producer only. Returns false if the ring is full. */
+    bool push (const T& item)
+    {
+        const uint64_t tail = m_tail.load (std::memory_order_relaxed);
+        if (tail - m_head.load (std::memory_order_acquire) > m_mask)
+            return false;
+
+        m_items[tail & m_mask] = item;
+        m_tail.store (tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer only. Returns false if there is nothing to pop. */
+    bool pop (T& item)
+    {
+        const uint64_t head = m_head.load (std::memory_order_relaxed);
+        if (head == m_tail.load (std::memory_order_acquire))
+            return false;
+
+        item = m_items[head & m_mask];
+        m_head.store (head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief popAll hands every item pushed so far to read (const T* items, size_t count),
+     * in at most two contiguous spans, before and after the wrap. Consumer only.
+     * Returns the number of items popped.
+     */
+    template <typename Read>
+    size_t popAll (Read&& read)
+    {
+        const uint64_t head = m_head.load (std::memory_order_relaxed);
+        const uint64_t tail = m_tail.load (std::memory_order_acquire);
+        if (tail == head)
+            return 0;
+
+        const uint64_t size = m_mask + 1;
+        const uint64_t first = head & m_mask;
+        const uint64_t count = tail - head;
+        const uint64_t firstSpan = count < size - first ? count : size - first;
+
+        read (&m_items[first], size_t (firstSpan));
+        if (count > firstSpan)
+            read (&m_items[0], size_t (count - firstSpan));
+
+        m_head.store (tail, std::memory_order_release);
+        return size_t (count);
+    }
+
+    /** Consumer only, the oldest item. Only valid when not empty. */
+    const T& front() const { return m_items[m_head.load (std::memory_order_relaxed) & m_mask]; }
+
+    /** Consumer only, or while the consumer is not running. */
+    void clear() { m_head.store (m_tail.load (std::memory_order_acquire), std::memory_order_release); }
+
+    bool isEmpty() const { return getNumPending() == 0; }
+    int getNumPending() const { return int (m_tail.load (std::memory_order_acquire) - m_head.load (std::memory_order_acquire)); }
+    int getCapacity() const { return int (m_mask + 1); }
+
+private:
+    std::vector<T> m_items;
+    uint64_t m_mask;
+    std::atomic<uint64_t> m_head;
+    std::atomic<uint64_t> m_tail;
+
+    SpscRing (const SpscRing&) = delete;
+    SpscRing& operator= (const SpscRing&) = delete;
+};
+
+#endif  // __SPSCRING_H_3A81D6C0__
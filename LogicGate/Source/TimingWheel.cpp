@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimingWheel.h"
+
+static void makeEmpty (TimerNode& head)
+{
+    head.prev = &head;
+    head.next = &head;
+}
+
+TimingWheel::TimingWheel()
+    : m_total(0),
+      m_now(0)
+{
+    for (int l = 0; l < LEVELS; l++)
+        for (int s = 0; s < SLOTS; s++)
+            makeEmpty (m_slots[l][s]);
+    makeEmpty (m_overflow);
+
+    for (int l = 0; l < LEVELS; l++)
+        for (int w = 0; w < SLOTS / 64; w++)
+            m_occupied[l][w] = 0;
+    for (int l = 0; l <= LEVELS; l++)
+        m_count[l] = 0;
+}
+
+TimingWheel::~TimingWheel()
+{
+}
+
+void TimingWheel::reset (int64_t now)
+{
+    for (int l = 0; l < LEVELS; l++)
+    {
+        for (int s = 0; s < SLOTS; s++)
+        {
+            TimerNode& head = m_slots[l][s];
+            while (head.next != &head)
+                unlink (*head.next);
+        }
+    }
+    while (m_overflow.next != &m_overflow)
+        unlink (*m_overflow.next);
+
+    m_now = now;
+}
+
+void TimingWheel::schedule (TimerNode& node, int64_t when)
+{
+    if (node.isScheduled())
+        unlink (node);
+
+    node.when = when;
+    insert (node);
+}
+
+void TimingWheel::cancel (TimerNode& node)
+{
+    if (node.isScheduled())
+        unlink (node);
+}
+
+void TimingWheel::insert (TimerNode& node)
+{
+    // late deadlines are due in the current slot
+    const int64_t t = node.when < m_now ? m_now : node.when;
+    const uint64_t diff = uint64_t (t) ^ uint64_t (m_now);
+
+    for (int level = 0; level < LEVELS; level++)
+    {
+        const int shift = SLOT_BITS * (level + 1);
+        if ((diff >> shift) == 0)
+        {
+            const int slot = int ((uint64_t (t) >> (SLOT_BITS * level)) & (SLOTS - 1));
+            link (m_slots[level][slot], node, level, slot);
+            return;
+        }
+    }
+
+    link (m_overflow, node, LEVELS, 0);
+}
+
+void TimingWheel::link (TimerNode& head, TimerNode& node, int level, int slot)
+{
+    node.level = level;
+    node.slot = slot;
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+
+    if (level < LEVELS)
+        m_occupied[level][slot >> 6] |= uint64_t (1) << (slot & 63);
+    m_count[level]++;
+    m_total++;
+}
+
+void TimingWheel::unlink (TimerNode& node)
+{
+    TimerNode* next = node.next;
+    node.prev->next = next;
+    next->prev = node.prev;
+    node.prev = nullptr;
+    node.next = nullptr;
+
+    // the successor is the slot head when the slot just became empty
+    if (node.level < LEVELS && next->next == next)
+        m_occupied[node.level][node.slot >> 6] &= ~(uint64_t (1) << (node.slot & 63));
+    m_count[node.level]--;
+    m_total--;
+}
+
+void TimingWheel::cascade (int64_t t)
+{
+    // highest level whose slot boundary is t, the overflow list counts as level LEVELS
+    int top = 0;
+    while (top < LEVELS && ((uint64_t (t) >> (SLOT_BITS * (top + 1))) << (SLOT_BITS * (top + 1))) == uint64_t (t))
+        ++top;
+
+    if (top == LEVELS)
+    {
+        reinsertAll (m_overflow);
+        --top;
+    }
+
+    for (int level = top; level >= 1; level--)
+    {
+        const int slot = int ((uint64_t (t) >> (SLOT_BITS * level)) & (SLOTS - 1));
+        if (m_count[level] > 0)
+            reinsertAll (m_slots[level][slot]);
+    }
+}
+
+void TimingWheel::reinsertAll (TimerNode& head)
+{
+    // detach the whole list first so nodes landing back in the same list are not revisited
+    TimerNode* node = head.next;
+    if (node == &head)
+        return;
+
+    TimerNode* last = head.prev;
+    makeEmpty (head);
+    last->next = nullptr;
+
+    while (node != nullptr)
+    {
+        TimerNode* next = node->next;
+        if (node->level < LEVELS)
+            m_occupied[node->level][node->slot >> 6] &= ~(uint64_t (1) << (node->slot & 63));
+        m_count[node->level]--;
+        m_total--;
+        node->prev = nullptr;
+        node->next = nullptr;
+        insert (*node);
+        node = next;
+    }
+}
+
+int TimingWheel::findNextSlot (int level, int from) const
+{
+    for (int w = from >> 6; w < SLOTS / 64; w++)
+    {
+        uint64_t bits = m_occupied[level][w];
+        if (w == (from >> 6))
+            bits &= ~uint64_t (0) << (from & 63);
+        if (bits != 0)
+        {
+            int bit = 0;
+            while ((bits & 1) == 0)
+            {
+                bits >>= 1;
+                ++bit;
+            }
+            return (w << 6) + bit;
+        }
+    }
+    return -1;
+}
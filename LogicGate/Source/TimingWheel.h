@@ -0,0 +1,160 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __TIMINGWHEEL_H_3C1E7A52__
+#define __TIMINGWHEEL_H_3C1E7A52__
+
+#include <cstdint>
+
+/**
+ * @brief The TimerNode struct is an intrusive deadline owned by whoever schedules it.
+ * A node is in at most one slot of one wheel; scheduling it again moves it.
+ * owner and kind are free for the owner to tell its deadlines apart.
+ */
+struct TimerNode
+{
+    int64_t when = 0;
+    int owner = 0;
+    int kind = 0;
+
+    TimerNode* prev = nullptr;
+    TimerNode* next = nullptr;
+    int level = 0;
+    int slot = 0;
+
+    bool isScheduled() const { return prev != nullptr; }
+};
+
+/**
+    Hierarchical timing wheel keyed in samples.
+
+    Four levels of 256 slots cover 2^32 samples (about 12 h at 100 kHz); later
+    deadlines wait in an overflow list. Level 0 has single-sample resolution, so
+    deadlines fire at their exact sample and in time order. advance() only visits
+    occupied slots and the level boundaries where something has to cascade down,
+    so a buffer with no deadline in it costs a few bitmap tests.
+
+    Nodes are owned by the caller, nothing is allocated after construction. The
+    wheel never touches its nodes once it is destroyed.
+*/
+class TimingWheel
+{
+public:
+    TimingWheel();
+    ~TimingWheel();
+
+    /** Drops every scheduled node and restarts the clock at now. */
+    void reset (int64_t now);
+
+    /** Schedules (or reschedules) node at when. Deadlines in the past fire on the next advance(). */
+    void schedule (TimerNode& node, int64_t when);
+
+    /** Unschedules node, does nothing if it is not scheduled. */
+    void cancel (TimerNode& node);
+
+    /** Time up to which deadlines have been fired. */
+    int64_t getNow() const { return m_now; }
+    bool isEmpty() const { return m_total == 0; }
+
+    /**
+     * @brief advance fires, in time order, every deadline earlier than until.
+     * onExpire(TimerNode&) may schedule nodes, including the one it is handed.
+     */
+    template <typename Callback>
+    void advance (int64_t until, Callback&& onExpire)
+    {
+        while (m_now < until)
+        {
+            if (m_total == 0)
+            {
+                m_now = until;
+                return;
+            }
+
+            // level 0: next occupied slot of the current block
+            const int64_t blockStart = m_now & ~int64_t (SLOTS - 1);
+            const int64_t blockEnd = blockStart + SLOTS;
+            const int slot = findNextSlot (0, int (m_now - blockStart));
+
+            if (slot >= 0 && blockStart + slot < until)
+            {
+                m_now = blockStart + slot;
+                TimerNode& head = m_slots[0][slot];
+                while (head.next != &head)
+                {
+                    TimerNode* node = head.next;
+                    unlink (*node);
+                    onExpire (*node);
+                }
+                if (++m_now == blockEnd)
+                    cascade (m_now);
+                continue;
+            }
+
+            if (until < blockEnd)
+            {
+                m_now = until;
+                return;
+            }
+
+            // nothing left in level 0: jump to the next boundary of the lowest occupied level
+            int level = 1;
+            while (level < LEVELS && m_count[level] == 0)
+                ++level;
+            const int shift = SLOT_BITS * level;
+            const int64_t boundary = ((m_now >> shift) + 1) << shift;
+
+            if (boundary > until)
+            {
+                m_now = until;
+                return;
+            }
+            m_now = boundary;
+            cascade (m_now);
+        }
+    }
+
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;
+
+private:
+    void insert (TimerNode& node);
+    void link (TimerNode& head, TimerNode& node, int level, int slot);
+    void unlink (TimerNode& node);
+    /** Redistributes the slots that start at time t into the levels below. */
+    void cascade (int64_t t);
+    void reinsertAll (TimerNode& head);
+    int findNextSlot (int level, int from) const;
+
+    TimerNode m_slots[LEVELS][SLOTS];
+    TimerNode m_overflow;
+    uint64_t m_occupied[LEVELS][SLOTS / 64];
+    int m_count[LEVELS + 1];
+    int m_total;
+    int64_t m_now;
+
+    TimingWheel (const TimingWheel&) = delete;
+    TimingWheel& operator= (const TimingWheel&) = delete;
+};
+
+#endif  // __TIMINGWHEEL_H_3C1E7A52__
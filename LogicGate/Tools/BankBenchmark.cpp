@@ -0,0 +1,240 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+    Times a large GateBank the way LogicGate::process drives it, buffer by
+    buffer at the real buffer rate, for a list of thread counts, and prints
+    the time per buffer against the buffer's real-time budget. Pacing keeps
+    the worker pool idle between buffers as it is in the plugin; --unpaced
+    runs the buffers back to back.
+
+    The bank is synthetic: chains of gates, each chain reading random TTL
+    lines, fed with Poisson edges on every line. Every parallel run must
+    produce exactly the same output sequence, and the same outputs as the
+    single-threaded run once sorted; the tool fails otherwise.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BankTools.h"
+
+static void printUsage (const char* name)
+{
+    fprintf (stderr,
+             "usage: %s [--gates <n>] [--chain <n>] [--lines <n>] [--edge-rate <Hz>]\n"
+             "          [--rate <Hz>] [--buffer <samples>] [--seconds <s>] [--threads <list>]\n"
+             "          [--unpaced]\n"
+             "\n"
+             "Gates are wired in independent chains of --chain gates (default 512 gates,\n"
+             "chains of 4, 2048 lines with 20 edges/s each, 30 kHz, 1024 sample buffers,\n"
+             "10 s). --threads is a comma separated list, default 1,2,4,... up to the\n"
+             "number of hardware threads.\n", name);
+}
+
+struct RunResult
+{
+    double meanLoad;
+    double p99Load;
+    double worstLoad;
+    double seconds;
+    int groups;
+    std::vector<Output> outputs;
+};
+
+static RunResult runBank (const std::vector<GateBank::Gate>& gates, const std::vector<Edge>& edges,
+                          int numThreads, int bufferSamples, int64_t totalSamples, double sampleRate, bool paced)
+{
+    OutputCollector collector;
+    collector.outputs.reserve (edges.size());
+    GateBank bank (collector);
+    bank.setNumThreads (numThreads);
+    bank.setGates (gates);
+    bank.reset (0);
+
+    const double budget = bufferSamples / sampleRate;
+    std::vector<double> loads;
+    loads.reserve (size_t (totalSamples / bufferSamples + 1));
+
+    const auto start = std::chrono::steady_clock::now();
+    double busy = 0;
+    size_t next = 0;
+    for (int64_t bufferStart = 0; bufferStart < totalSamples; bufferStart += bufferSamples)
+    {
+        // a buffer is handed over once its last sample has been acquired
+        if (paced)
+            std::this_thread::sleep_until (start + std::chrono::duration_cast<std::chrono::steady_clock::duration> (
+                                               std::chrono::duration<double> ((bufferStart + bufferSamples) / sampleRate)));
+
+        const auto bufferBegan = std::chrono::steady_clock::now();
+
+        const int64_t bufferEnd = bufferStart + bufferSamples;
+        for (; next < edges.size() && edges[next].timestamp < bufferEnd; next++)
+            bank.inputEdge (edges[next].line, edges[next].timestamp);
+        bank.advanceTo (bufferEnd);
+
+        const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - bufferBegan).count();
+        loads.push_back (elapsed / budget * 100.0);
+        busy += elapsed;
+    }
+
+    RunResult result;
+    result.seconds = busy;
+    result.groups = bank.getNumGroups();
+    result.outputs.swap (collector.outputs);
+
+    double sum = 0;
+    for (double load : loads)
+        sum += load;
+    result.meanLoad = loads.empty() ? 0 : sum / loads.size();
+    std::sort (loads.begin(), loads.end());
+    result.p99Load = loads.empty() ? 0 : loads[std::min (loads.size() - 1, loads.size() * 99 / 100)];
+    result.worstLoad = loads.empty() ? 0 : loads.back();
+    return result;
+}
+
+int main (int argc, char* argv[])
+{
+    int numGates = 512;
+    int chain = 4;
+    int numLines = 2048;
+    double edgeRate = 20;
+    double sampleRate = 30000;
+    int bufferSamples = 1024;
+    double seconds = 10;
+    bool paced = true;
+    std::vector<int> threadCounts;
+    bool valid = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp (argv[i], "--gates") == 0 && hasValue)
+            numGates = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--chain") == 0 && hasValue)
+            chain = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--lines") == 0 && hasValue)
+            numLines = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--edge-rate") == 0 && hasValue)
+            edgeRate = atof (argv[++i]);
+        else if (strcmp (argv[i], "--rate") == 0 && hasValue)
+            sampleRate = atof (argv[++i]);
+        else if (strcmp (argv[i], "--buffer") == 0 && hasValue)
+            bufferSamples = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--seconds") == 0 && hasValue)
+            seconds = atof (argv[++i]);
+        else if (strcmp (argv[i], "--unpaced") == 0)
+            paced = false;
+        else if (strcmp (argv[i], "--threads") == 0 && hasValue)
+            valid = parseThreadCounts (argv[++i], threadCounts) && valid;
+        else
+            valid = false;
+    }
+
+    if (!valid || numGates < 1 || chain < 1 || numLines < 1 || edgeRate <= 0
+        || sampleRate <= 0 || bufferSamples < 1 || seconds <= 0)
+    {
+        printUsage (argv[0]);
+        return 1;
+    }
+
+    if (threadCounts.empty())
+    {
+        const int cores = std::max (1, int (std::thread::hardware_concurrency()));
+        for (int n = 1; n < cores; n *= 2)
+            threadCounts.push_back (n);
+        threadCounts.push_back (cores);
+    }
+
+    // chains of gates: the first reads two lines, the others the previous gate and a line
+    std::mt19937 random (1);
+    std::vector<GateBank::Gate> gates (numGates);
+    for (int g = 0; g < numGates; g++)
+    {
+        GateBank::Gate& gate = gates[g];
+        gate.config.logicOp = int (random() % 3);
+        gate.config.windowSamples = GateEngine::msToSamples (1 + int (random() % 50), float (sampleRate));
+        gate.config.durationSamples = GateEngine::msToSamples (2, float (sampleRate));
+        gate.config.outputChan = int (random() % 8);
+        gate.inputs[0] = (g % chain == 0) ? int (random() % numLines) : GateBank::gateInput (g - 1);
+        gate.inputs[1] = int (random() % numLines);
+    }
+
+    // Poisson edges on every line, merged in time
+    const int64_t totalSamples = int64_t (seconds * sampleRate);
+    std::vector<Edge> edges;
+    std::exponential_distribution<double> interval (edgeRate / sampleRate);
+    for (int line = 0; line < numLines; line++)
+        for (double t = interval (random); t < totalSamples; t += interval (random))
+        {
+            Edge edge = { int64_t (t), line };
+            edges.push_back (edge);
+        }
+    std::stable_sort (edges.begin(), edges.end(), [] (const Edge& a, const Edge& b) { return a.timestamp < b.timestamp; });
+
+    printf ("%d gates in chains of %d, %d lines, %zu edges, %.0f s at %.0f Hz, %d sample buffers (%.2f ms budget)\n",
+            numGates, chain, numLines, edges.size(), seconds, sampleRate, bufferSamples, bufferSamples / sampleRate * 1000.0);
+    printf ("threads  groups   mean%%    p99%%    max%%    busy s  speedup\n");
+
+    std::vector<Output> sequential;
+    std::vector<Output> parallel;
+    double baseline = 0;
+    for (size_t run = 0; run < threadCounts.size(); run++)
+    {
+        RunResult result = runBank (gates, edges, threadCounts[run], bufferSamples, totalSamples, sampleRate, paced);
+        if (run == 0)
+            baseline = result.seconds;
+        printf ("%7d %7d %7.2f %7.2f %7.2f %9.3f %8.2f\n", threadCounts[run], result.groups,
+                result.meanLoad, result.p99Load, result.worstLoad, result.seconds, baseline / result.seconds);
+
+        // parallel runs merge outputs in one deterministic order, the single thread run groups them by gate
+        if (threadCounts[run] > 1)
+        {
+            if (parallel.empty())
+                parallel = result.outputs;
+            else if (result.outputs != parallel)
+            {
+                fprintf (stderr, "%d threads produced a different output sequence\n", threadCounts[run]);
+                return 1;
+            }
+        }
+        std::sort (result.outputs.begin(), result.outputs.end());
+
+        if (sequential.empty())
+            sequential.swap (result.outputs);
+        else if (result.outputs != sequential)
+        {
+            fprintf (stderr, "%d threads produced different outputs\n", threadCounts[run]);
+            return 1;
+        }
+    }
+
+    printf ("%zu outputs, identical for every thread count\n", sequential.size());
+    return 0;
+}
@@ -0,0 +1,677 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+    Checks the scheduling shortcuts of the decision logic against brute force
+    on random inputs, and fails on the first difference.
+
+    TimingWheel: random schedules, reschedules and cancels, deadlines in the
+    past, on the same sample, and on every level of the wheel and beyond, are
+    fired in time order at their own sample, as a plain list of deadlines says.
+
+    GateBank: random gate graphs fed with random TTL edges, several of them on
+    one sample, must give the outputs of the same gates as plain GateEngines
+    stepped one sample at a time, every gate in dependency order. The bank is
+    advanced in random buffer lengths. With worker threads each buffer's edges
+    are delivered out of order (edges of one sample keep theirs); with one
+    thread they are delivered sorted, as LogicGate::process does.
+
+    Immediate mode: single OR and XOR engines on random edges fire the same
+    windows with and without it.
+
+    Fixed cases: a chain of gates with known firing times, a rewire in the
+    buffer of a reconfiguration, and DELAY pulses that overlap.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BankTools.h"
+
+static void printUsage (const char* name)
+{
+    fprintf (stderr,
+             "usage: %s [--trials <n>] [--seed <n>] [--threads <list>]\n"
+             "\n"
+             "Runs --trials random timing wheels and random gate banks (default 50,\n"
+             "seed 1). Every bank is run once per entry of --threads, a comma separated\n"
+             "list, default 1,2,4.\n", name);
+}
+
+//==============================================================================
+/** Deadline (timestamp, owner) pairs fired by one advance, or due in it */
+typedef std::vector<std::pair<int64_t, int>> Firings;
+
+static bool checkWheel (std::mt19937_64& random, int trial)
+{
+    // near a level 3 boundary in some trials, so that cascades are crossed
+    const int64_t start = random() % 3 == 0 ? (int64_t (1) << 32) - 5000 : int64_t (random() % 100000);
+    TimingWheel wheel;
+    wheel.reset (start);
+
+    const int numNodes = 300;
+    std::vector<TimerNode> nodes (numNodes);
+    std::map<int, int64_t> scheduled;
+    int64_t now = start;
+
+    for (int step = 0; step < 2000; step++)
+    {
+        const int node = int (random() % numNodes);
+        switch (random() % 4)
+        {
+        case 0:
+        case 1:
+        {
+            // a few samples in the past up to beyond the last level
+            const int64_t range = random() % 5 == 0 ? (int64_t (1) << 34) : (random() % 2 == 0 ? 300 : 100000);
+            const int64_t when = now + int64_t (random() % uint64_t (range)) - 10;
+            nodes[node].owner = node;
+            wheel.schedule (nodes[node], when);
+            scheduled[node] = when;
+            break;
+        }
+        case 2:
+            wheel.cancel (nodes[node]);
+            scheduled.erase (node);
+            break;
+        default:
+        {
+            const int64_t until = now + int64_t (random() % 2 == 0 ? random() % 2000 : random() % (uint64_t (1) << 33));
+
+            // deadlines in the past fire at the first sample of the advance
+            Firings expected;
+            for (const auto& deadline : scheduled)
+                if (std::max (deadline.second, now) < until)
+                    expected.push_back (std::make_pair (std::max (deadline.second, now), deadline.first));
+
+            Firings fired;
+            wheel.advance (until, [&] (TimerNode& n) { fired.push_back (std::make_pair (std::max (n.when, now), n.owner)); });
+
+            for (size_t i = 1; i < fired.size(); i++)
+            {
+                if (fired[i].first < fired[i - 1].first)
+                {
+                    fprintf (stderr, "wheel trial %d step %d: deadline %lld fired after %lld\n", trial, step,
+                             (long long) fired[i].first, (long long) fired[i - 1].first);
+                    return false;
+                }
+            }
+
+            // the order within a sample is free
+            std::sort (expected.begin(), expected.end());
+            std::sort (fired.begin(), fired.end());
+            if (fired != expected || wheel.getNow() != until)
+            {
+                fprintf (stderr, "wheel trial %d step %d: %zu deadlines fired before %lld, %zu were due\n", trial, step,
+                         fired.size(), (long long) until, expected.size());
+                return false;
+            }
+
+            for (const auto& firing : fired)
+                scheduled.erase (firing.second);
+            now = until;
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+//==============================================================================
+/**
+    The brute force model of a GateBank: one GateEngine per gate, all of them
+    advanced sample by sample in the bank's dependency order. A gate's edges of
+    one sample are applied after its own deadlines of that sample, those caused
+    by deadlines upstream first, then those of each TTL edge in delivery order.
+*/
+class ReferenceBank
+{
+public:
+    explicit ReferenceBank (const std::vector<GateBank::Gate>& gates)
+        : m_pending (gates.size())
+    {
+        GateBank::sortGates (gates, m_order);
+        for (size_t g = 0; g < gates.size(); g++)
+        {
+            m_nodes.emplace_back (new Node (*this));
+            m_nodes.back()->engine.setConfig (gates[g].config);
+            m_nodes.back()->engine.reset (0);
+        }
+
+        // readers of each line and of each gate, as gate * 2 + input
+        for (size_t g = 0; g < gates.size(); g++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                const int input = gates[g].inputs[i];
+                if (GateBank::isGateInput (input))
+                    m_nodes[GateBank::inputGate (input)]->consumers.push_back (int (g) * 2 + i);
+                else if (input != GateBank::NO_INPUT)
+                    m_lines[input].push_back (int (g) * 2 + i);
+            }
+        }
+    }
+
+    /** Feeds edges, sorted by timestamp, and returns false if an output lands on another sample than its cause */
+    bool run (const std::vector<Edge>& edges, int64_t end, std::vector<Output>& outputs)
+    {
+        m_outputs = &outputs;
+        size_t next = 0;
+        for (m_now = 0; m_now < end; m_now++)
+        {
+            for (; next < edges.size() && edges[next].timestamp == m_now; next++)
+            {
+                auto readers = m_lines.find (edges[next].line);
+                if (readers == m_lines.end())
+                    continue;
+                for (int reader : readers->second)
+                {
+                    PendingEdge edge = { reader & 1, int (next) };
+                    m_pending[reader >> 1].push_back (edge);
+                }
+            }
+
+            for (int g : m_order)
+            {
+                Node& node = *m_nodes[g];
+                node.cause = -1;
+                node.engine.advanceTo (m_now + 1);
+
+                std::vector<PendingEdge>& pending = m_pending[g];
+                std::stable_sort (pending.begin(), pending.end(),
+                                  [] (const PendingEdge& a, const PendingEdge& b) { return a.sequence < b.sequence; });
+                for (const PendingEdge& edge : pending)
+                {
+                    node.cause = edge.sequence;
+                    node.engine.inputEdge (edge.input, m_now);
+                }
+                pending.clear();
+            }
+        }
+        return m_consistent;
+    }
+
+private:
+    struct PendingEdge
+    {
+        int input;
+        int sequence;
+    };
+
+    struct Node : public GateEngine::Listener
+    {
+        explicit Node (ReferenceBank& owner) : reference(owner), engine(*this), cause(-1) {}
+
+        void gateOutput (int64_t timestamp, bool on, int outputChan) override
+        {
+            if (outputChan >= 0)
+            {
+                Output output = { timestamp, outputChan, on };
+                reference.m_outputs->push_back (output);
+            }
+            if (!on)
+                return;
+            if (timestamp != reference.m_now)
+                reference.m_consistent = false;
+            for (int consumer : consumers)
+            {
+                PendingEdge edge = { consumer & 1, cause };
+                reference.m_pending[consumer >> 1].push_back (edge);
+            }
+        }
+
+        ReferenceBank& reference;
+        GateEngine engine;
+        int cause;
+        std::vector<int> consumers;
+    };
+
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::vector<int> m_order;
+    std::vector<std::vector<PendingEdge>> m_pending;
+    std::map<int, std::vector<int>> m_lines;
+    std::vector<Output>* m_outputs = nullptr;
+    int64_t m_now = 0;
+    bool m_consistent = true;
+};
+
+/** Reorders a buffer's edges at random, edges of one sample keep their order */
+static void shuffleBuffer (std::vector<Edge>& edges, std::mt19937& random)
+{
+    const std::vector<Edge> sorted (edges);
+    std::shuffle (edges.begin(), edges.end(), random);
+
+    // each place the shuffle gave to a sample takes that sample's next edge
+    std::map<int64_t, size_t> nextOfSample;
+    for (size_t i = sorted.size(); i-- > 0; )
+        nextOfSample[sorted[i].timestamp] = i;
+    for (Edge& edge : edges)
+        edge = sorted[nextOfSample[edge.timestamp]++];
+}
+
+static bool runBank (const std::vector<GateBank::Gate>& gates, const std::vector<Edge>& edges,
+                     int numThreads, int64_t end, unsigned int seed, std::vector<Output>& outputs)
+{
+    OutputCollector collector;
+    GateBank bank (collector);
+    bank.setNumThreads (numThreads);
+    if (!bank.setGates (gates))
+        return false;
+    bank.reset (0);
+
+    std::mt19937 random (seed);
+    std::vector<Edge> buffer;
+    size_t next = 0;
+    for (int64_t bufferStart = 0; bufferStart < end; )
+    {
+        const int64_t bufferEnd = std::min (end, bufferStart + 1 + int64_t (random() % 2048));
+
+        buffer.clear();
+        for (; next < edges.size() && edges[next].timestamp < bufferEnd; next++)
+            buffer.push_back (edges[next]);
+        if (bank.isParallel())
+            shuffleBuffer (buffer, random);
+
+        for (const Edge& edge : buffer)
+            bank.inputEdge (edge.line, edge.timestamp);
+        bank.advanceTo (bufferEnd);
+        bufferStart = bufferEnd;
+    }
+
+    outputs.swap (collector.outputs);
+    return true;
+}
+
+static bool checkBank (std::mt19937& random, int trial, const std::vector<int>& threadCounts, size_t& numOutputs)
+{
+    const int numGates = 2 + int (random() % 40);
+    const int numLines = 1 + int (random() % 8);
+
+    // a random graph, gates only read gates made before them, then numbered at random
+    std::vector<GateBank::Gate> made (numGates);
+    for (int g = 0; g < numGates; g++)
+    {
+        GateConfig& config = made[g].config;
+        config.logicOp = int (random() % 4);
+        config.windowSamples = 1 + int (random() % 300);
+        config.durationSamples = 1 + int (random() % 20);
+        config.immediate = random() % 2 == 0;
+        config.gate1 = random() % 5 == 0;
+        config.gate2 = random() % 5 == 0;
+        for (int i = 0; i < 2; i++)
+        {
+            const int kind = int (random() % 3);
+            if (kind == 0 && g > 0)
+                made[g].inputs[i] = GateBank::gateInput (int (random() % g));
+            else if (kind == 1)
+                made[g].inputs[i] = int (random() % numLines);
+        }
+    }
+
+    std::vector<int> number (numGates);
+    for (int g = 0; g < numGates; g++)
+        number[g] = g;
+    std::shuffle (number.begin(), number.end(), random);
+
+    std::vector<GateBank::Gate> gates (numGates);
+    for (int g = 0; g < numGates; g++)
+    {
+        GateBank::Gate gate = made[g];
+        for (int i = 0; i < 2; i++)
+            if (GateBank::isGateInput (gate.inputs[i]))
+                gate.inputs[i] = GateBank::gateInput (number[GateBank::inputGate (gate.inputs[i])]);
+        // every gate on its own line, some only feed other gates
+        gate.config.outputChan = random() % 4 == 0 ? -1 : number[g];
+        gates[number[g]] = gate;
+    }
+
+    // edges on random lines, one in six on the same sample as the one before
+    std::vector<Edge> edges;
+    int64_t t = 0;
+    for (int e = 0; e < 4000; e++)
+    {
+        t += random() % 6 == 0 ? 0 : 1 + int64_t (random() % 120);
+        Edge edge = { t, int (random() % numLines) };
+        edges.push_back (edge);
+    }
+    const int64_t end = t + 2000;
+
+    std::vector<Output> expected;
+    ReferenceBank reference (gates);
+    if (!reference.run (edges, end, expected))
+    {
+        fprintf (stderr, "bank trial %d: the reference output a rising edge on another sample than its cause\n", trial);
+        return false;
+    }
+    std::sort (expected.begin(), expected.end());
+
+    for (int numThreads : threadCounts)
+    {
+        std::vector<Output> outputs;
+        if (!runBank (gates, edges, numThreads, end, unsigned (trial), outputs))
+        {
+            fprintf (stderr, "bank trial %d: gates rejected\n", trial);
+            return false;
+        }
+        std::sort (outputs.begin(), outputs.end());
+
+        if (outputs != expected)
+        {
+            const size_t first = std::mismatch (outputs.begin(), outputs.begin() + std::min (outputs.size(), expected.size()),
+                                                expected.begin()).first - outputs.begin();
+            fprintf (stderr, "bank trial %d, %d threads: %zu outputs, %zu expected, first difference at %zu (sample %lld)\n",
+                     trial, numThreads, outputs.size(), expected.size(), first,
+                     (long long) (first < expected.size() ? expected[first].timestamp : outputs[first].timestamp));
+            return false;
+        }
+    }
+
+    numOutputs += expected.size();
+    return true;
+}
+
+/**
+    DELAY replays every edge of A as its own pulse: edges closer together than
+    the pulse duration end the previous pulse on the sample of the next one.
+*/
+static bool checkDelay (const std::vector<int>& threadCounts)
+{
+    std::vector<GateBank::Gate> gates (1);
+    gates[0].config.logicOp = LOGIC_DELAY;
+    gates[0].config.windowSamples = 100;
+    gates[0].config.durationSamples = 50;
+    gates[0].inputs[0] = 0;
+
+    const Output expected[] = { { 100, 0, true }, { 120, 0, false }, { 120, 0, true },
+                                { 140, 0, false }, { 140, 0, true }, { 190, 0, false } };
+
+    for (int numThreads : threadCounts)
+    {
+        OutputCollector collector;
+        GateBank bank (collector);
+        bank.setNumThreads (numThreads);
+        bank.setGates (gates);
+        bank.reset (0);
+
+        for (int64_t timestamp : { 0, 20, 40 })
+            bank.inputEdge (0, timestamp);
+        bank.advanceTo (1000);
+
+        // in the order they were sent
+        if (collector.outputs != std::vector<Output> (expected, expected + 6))
+        {
+            fprintf (stderr, "delay, %d threads: %zu outputs, 6 expected\n", numThreads, collector.outputs.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Rising edges of one engine fed the given edges on inputs 0 and 1 */
+static std::vector<int64_t> runEngine (const GateConfig& config, const std::vector<Edge>& edges)
+{
+    OutputCollector collector;
+    GateEngine engine (collector);
+    engine.setConfig (config);
+    engine.reset (0);
+    for (const Edge& edge : edges)
+        engine.inputEdge (edge.line, edge.timestamp);
+    engine.advanceTo (edges.empty() ? 1 : edges.back().timestamp + config.windowSamples + 1);
+
+    std::vector<int64_t> fired;
+    for (const Output& output : collector.outputs)
+        if (output.on)
+            fired.push_back (output.timestamp);
+    return fired;
+}
+
+/**
+    Immediate mode only moves decisions earlier: OR fires at the first edge of
+    each window instead of at its end, XOR fires at the same window ends. The
+    fixed case A@0 B@10 A@20 in a 50 sample window must not fire XOR either way.
+*/
+static bool checkImmediate (std::mt19937& random, int trials)
+{
+    const Edge probe[] = { { 0, 0 }, { 10, 1 }, { 20, 0 } };
+    std::vector<std::vector<Edge>> trains (1, std::vector<Edge> (probe, probe + 3));
+    for (int trial = 0; trial < trials; trial++)
+    {
+        std::vector<Edge> edges;
+        int64_t t = 0;
+        for (int e = 0; e < 2000; e++)
+        {
+            t += random() % 6 == 0 ? 0 : 1 + int64_t (random() % 120);
+            Edge edge = { t, int (random() % 2) };
+            edges.push_back (edge);
+        }
+        trains.push_back (edges);
+    }
+
+    for (size_t train = 0; train < trains.size(); train++)
+    {
+        for (int logicOp : { int (LOGIC_OR), int (LOGIC_XOR) })
+        {
+            GateConfig config;
+            config.logicOp = logicOp;
+            config.windowSamples = train == 0 ? 50 : 1 + int (random() % 300);
+            config.durationSamples = 1;
+            config.outputChan = 0;
+
+            const std::vector<int64_t> windowed = runEngine (config, trains[train]);
+            config.immediate = true;
+            std::vector<int64_t> immediate = runEngine (config, trains[train]);
+            if (logicOp == LOGIC_OR)
+                for (int64_t& timestamp : immediate)
+                    timestamp += config.windowSamples;
+
+            if (immediate != windowed || (train == 0 && logicOp == LOGIC_XOR && !windowed.empty()))
+            {
+                fprintf (stderr, "immediate %s, train %zu, window %lld: %zu windows fired, %zu without immediate mode\n",
+                         logicOp == LOGIC_OR ? "OR" : "XOR", train, (long long) config.windowSamples, immediate.size(), windowed.size());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+    A fixed chain with firing times worked out by hand, so the bank's dirty
+    set and wake-up wheel are checked against the operators themselves, not
+    only against single engines: AND(line 0, line 1) -> DELAY -> OR immediate
+    (with line 2), and XOR(AND, OR). Gates are numbered out of dependency order.
+*/
+static bool checkChain (const std::vector<int>& threadCounts)
+{
+    enum { XOR_GATE, DELAY_GATE, AND_GATE, OR_GATE };
+    std::vector<GateBank::Gate> gates (4);
+    const int ops[] = { LOGIC_XOR, LOGIC_DELAY, LOGIC_AND, LOGIC_OR };
+    const int windows[] = { 40, 50, 100, 30 };
+    const int durations[] = { 5, 10, 10, 5 };
+    const int outputs[] = { 3, 1, 0, 2 };
+    for (int g = 0; g < 4; g++)
+    {
+        gates[g].config.logicOp = ops[g];
+        gates[g].config.windowSamples = windows[g];
+        gates[g].config.durationSamples = durations[g];
+        gates[g].config.outputChan = outputs[g];
+    }
+    gates[OR_GATE].config.immediate = true;
+    gates[AND_GATE].inputs[0] = 0;
+    gates[AND_GATE].inputs[1] = 1;
+    gates[DELAY_GATE].inputs[0] = GateBank::gateInput (AND_GATE);
+    gates[OR_GATE].inputs[0] = GateBank::gateInput (DELAY_GATE);
+    gates[OR_GATE].inputs[1] = 2;
+    gates[XOR_GATE].inputs[0] = GateBank::gateInput (AND_GATE);
+    gates[XOR_GATE].inputs[1] = GateBank::gateInput (OR_GATE);
+
+    // AND fires at 30 and its window at 500 expires, DELAY replays it at 80, OR fires
+    // at 80, drops 100 in its refractory window and fires at 200, XOR fires at the
+    // ends of its windows opened by AND at 30 and by OR at 80 and 200
+    const Edge edges[] = { { 10, 0 }, { 30, 1 }, { 100, 2 }, { 200, 2 }, { 500, 0 } };
+    const Output expected[] = { { 30, 0, true }, { 40, 0, false }, { 70, 3, true }, { 75, 3, false },
+                                { 80, 1, true }, { 80, 2, true }, { 85, 2, false }, { 90, 1, false },
+                                { 120, 3, true }, { 125, 3, false }, { 200, 2, true }, { 205, 2, false },
+                                { 240, 3, true }, { 245, 3, false } };
+    const size_t numExpected = sizeof (expected) / sizeof (expected[0]);
+
+    for (int numThreads : threadCounts)
+    {
+        OutputCollector collector;
+        GateBank bank (collector);
+        bank.setNumThreads (numThreads);
+        bank.setGates (gates);
+        bank.reset (0);
+
+        size_t next = 0;
+        for (int64_t bufferEnd = 64; bufferEnd <= 1024; bufferEnd += 64)
+        {
+            for (; next < sizeof (edges) / sizeof (edges[0]) && edges[next].timestamp < bufferEnd; next++)
+                bank.inputEdge (edges[next].line, edges[next].timestamp);
+            bank.advanceTo (bufferEnd);
+        }
+
+        std::sort (collector.outputs.begin(), collector.outputs.end());
+        if (collector.outputs != std::vector<Output> (expected, expected + numExpected))
+        {
+            fprintf (stderr, "chain, %d threads: %zu outputs, %zu expected\n", numThreads, collector.outputs.size(), numExpected);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+    A gate reconfigured while its pulse is high holds the OFF edge on its old
+    line until the next advanceTo(); a rewire in the same buffer must keep it
+    marked under the new layout. Gates 0 -> 1 and 2, then gate 1 is moved to
+    another line and disconnected, which splits the group it shared with 0.
+*/
+static bool checkRewire (const std::vector<int>& threadCounts)
+{
+    std::vector<GateBank::Gate> gates (3);
+    for (int g = 0; g < 3; g++)
+    {
+        gates[g].config.logicOp = LOGIC_OR;
+        gates[g].config.immediate = true;
+        gates[g].config.durationSamples = 1000;
+        gates[g].config.outputChan = g;
+    }
+    gates[0].inputs[0] = 0;
+    gates[1].inputs[0] = GateBank::gateInput (0);
+    gates[2].inputs[0] = 1;
+
+    const Output expected[] = { { 10, 0, true }, { 10, 1, true }, { 100, 1, false }, { 1010, 0, false } };
+
+    for (int numThreads : threadCounts)
+    {
+        OutputCollector collector;
+        GateBank bank (collector);
+        bank.setNumThreads (numThreads);
+        bank.setGates (gates);
+        bank.reset (0);
+
+        bank.inputEdge (0, 10);
+        bank.advanceTo (100);
+
+        std::vector<GateBank::Gate> rewired (gates);
+        rewired[1].inputs[0] = GateBank::NO_INPUT;
+        std::unique_ptr<GateBank::Wiring> wiring = GateBank::makeWiring (rewired, bank.isParallel());
+        rewired[1].config.outputChan = 3;
+        bank.setConfig (1, rewired[1].config);
+        bank.swapWiring (wiring);
+        bank.advanceTo (2000);
+
+        std::sort (collector.outputs.begin(), collector.outputs.end());
+        if (collector.outputs != std::vector<Output> (expected, expected + 4))
+        {
+            fprintf (stderr, "rewire, %d threads: %zu outputs, 4 expected\n", numThreads, collector.outputs.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main (int argc, char* argv[])
+{
+    int trials = 50;
+    unsigned int seed = 1;
+    std::vector<int> threadCounts;
+    bool valid = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp (argv[i], "--trials") == 0 && hasValue)
+            trials = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--seed") == 0 && hasValue)
+            seed = unsigned (strtoul (argv[++i], nullptr, 10));
+        else if (strcmp (argv[i], "--threads") == 0 && hasValue)
+            valid = parseThreadCounts (argv[++i], threadCounts) && valid;
+        else
+            valid = false;
+    }
+
+    if (!valid || trials < 1)
+    {
+        printUsage (argv[0]);
+        return 1;
+    }
+    if (threadCounts.empty())
+        threadCounts = { 1, 2, 4 };
+
+    std::mt19937_64 wheelRandom (seed);
+    for (int trial = 0; trial < trials; trial++)
+        if (!checkWheel (wheelRandom, trial))
+            return 1;
+    printf ("timing wheel: %d trials match the list of deadlines\n", trials);
+
+    std::mt19937 bankRandom (seed);
+    size_t numOutputs = 0;
+    for (int trial = 0; trial < trials; trial++)
+        if (!checkBank (bankRandom, trial, threadCounts, numOutputs))
+            return 1;
+    printf ("gate bank: %d trials, %zu outputs, the same as single engines for every thread count\n", trials, numOutputs);
+
+    if (!checkChain (threadCounts))
+        return 1;
+    printf ("chain: a fixed chain of gates fires at the times worked out by hand\n");
+
+    if (!checkRewire (threadCounts))
+        return 1;
+    printf ("rewire: edges held by a reconfigured gate survive a rewire in the same buffer\n");
+
+    if (!checkImmediate (bankRandom, trials))
+        return 1;
+    printf ("immediate mode: OR and XOR fire the same windows as without it in %d trials\n", trials);
+
+    if (!checkDelay (threadCounts))
+        return 1;
+    printf ("delay: edges closer than the pulse duration are replayed as separate pulses\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __BANKTOOLS_H_7C2A9E41__
+#define __BANKTOOLS_H_7C2A9E41__
+
+#include <cstdint>
+#include <cstdlib>
+#include <tuple>
+#include <vector>
+
+#include "GateBank.h"
+
+/**
+    Pieces shared by the GateBank tools (BankBenchmark, BankCheck): outputs
+    as the tools compare them, a listener that collects them, TTL edges to
+    feed, and the --threads list.
+*/
+
+/** An output edge of a gate, ordered by sample, line, then OFF before ON */
+struct Output
+{
+    int64_t timestamp;
+    int outputChan;
+    bool on;
+
+    bool operator< (const Output& o) const { return std::tie (timestamp, outputChan, on) < std::tie (o.timestamp, o.outputChan, o.on); }
+    bool operator== (const Output& o) const { return timestamp == o.timestamp && outputChan == o.outputChan && on == o.on; }
+};
+
+class OutputCollector : public GateEngine::Listener
+{
+public:
+    void gateOutput (int64_t timestamp, bool on, int outputChan) override
+    {
+        Output output = { timestamp, outputChan, on };
+        outputs.push_back (output);
+    }
+
+    std::vector<Output> outputs;
+};
+
+/** A rising TTL edge on an input line */
+struct Edge
+{
+    int64_t timestamp;
+    int line;
+};
+
+/**
+ * @brief parseThreadCounts appends the entries of a comma separated list of
+ * thread counts, and returns false if one is not a number of at least 1
+ */
+inline bool parseThreadCounts (const char* list, std::vector<int>& threadCounts)
+{
+    for (const char* item = list; *item != 0; )
+    {
+        char* end = nullptr;
+        const long n = strtol (item, &end, 10);
+        if (end == item || n < 1 || (*end != ',' && *end != 0))
+            return false;
+        threadCounts.push_back (int (n));
+        item = *end == ',' ? end + 1 : end;
+    }
+    return true;
+}
+
+#endif  // __BANKTOOLS_H_7C2A9E41__
@@ -0,0 +1,118 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+    Decodes a Logic Gate decision log (.lgdlog) into CSV on stdout.
+
+    usage: LogicGateLogDecoder <file.lgdlog> [--kind EDGE|FIRE|RESET|EXPIRE|DROP]
+*/
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "DecisionLog.h"
+
+static const int READ_CHUNK = 4096;
+
+static int parseKind (const char* name)
+{
+    for (int kind = DecisionRecord::EDGE; kind <= DecisionRecord::DROP; kind++)
+        if (strcmp (name, DecisionLog::kindName (kind)) == 0)
+            return kind;
+    return -1;
+}
+
+int main (int argc, char* argv[])
+{
+    const char* path = nullptr;
+    int onlyKind = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp (argv[i], "--kind") == 0 && i + 1 < argc)
+        {
+            onlyKind = parseKind (argv[++i]);
+            if (onlyKind < 0)
+            {
+                fprintf (stderr, "unknown record kind %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (path == nullptr)
+        {
+            path = argv[i];
+        }
+    }
+
+    if (path == nullptr)
+    {
+        fprintf (stderr, "usage: %s <file.lgdlog> [--kind EDGE|FIRE|RESET|EXPIRE|DROP]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* file = fopen (path, "rb");
+    if (file == nullptr)
+    {
+        fprintf (stderr, "cannot open %s\n", path);
+        return 1;
+    }
+
+    DecisionLogHeader header;
+    if (!DecisionLog::readHeader (file, header))
+    {
+        fprintf (stderr, "%s is not a version %u Logic Gate decision log\n", path, DecisionLog::VERSION);
+        fclose (file);
+        return 1;
+    }
+
+    fprintf (stderr, "sample rate %.1f Hz, %" PRIu64 " records dropped while recording\n",
+             header.sampleRate, header.droppedRecords);
+
+    printf ("timestamp,seconds,kind,value,source,channel,input\n");
+
+    static DecisionRecord records[READ_CHUNK];
+    uint64_t total = 0;
+    size_t n;
+    while ((n = fread (records, sizeof (DecisionRecord), READ_CHUNK, file)) > 0)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const DecisionRecord& r = records[i];
+            if (onlyKind != 0 && r.kind != onlyKind)
+                continue;
+
+            const double seconds = header.sampleRate > 0 ? r.timestamp / header.sampleRate : 0.0;
+            printf ("%" PRId64 ",%.6f,%s,%u,%u,%u,", r.timestamp, seconds, DecisionLog::kindName (r.kind),
+                    unsigned (r.value), unsigned (r.source), unsigned (r.channel));
+            if (r.input == 0xFFFF)
+                printf ("-\n");
+            else
+                printf ("%u\n", unsigned (r.input));
+        }
+        total += n;
+    }
+
+    fprintf (stderr, "%" PRIu64 " records\n", total);
+    fclose (file);
+    return 0;
+}
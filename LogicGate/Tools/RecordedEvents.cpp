@@ -0,0 +1,253 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RecordedEvents.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_data(nullptr),
+      m_size(0),
+#ifdef _WIN32
+      m_file(INVALID_HANDLE_VALUE),
+      m_mapping(nullptr)
+#else
+      m_fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open (const std::string& path)
+{
+    close();
+
+    m_file = CreateFileA (path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx (m_file, &size) || size.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA (m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*> (MapViewOfFile (m_mapping, FILE_MAP_READ, 0, 0, 0));
+    m_size = size_t (size.QuadPart);
+    if (m_data == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile (m_data);
+    if (m_mapping != nullptr)
+        CloseHandle (m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle (m_file);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open (const std::string& path)
+{
+    close();
+
+    m_fd = ::open (path.c_str(), O_RDONLY);
+    if (m_fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat (m_fd, &info) != 0 || info.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void* data = mmap (nullptr, size_t (info.st_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    // replay reads front to back exactly once
+    madvise (data, size_t (info.st_size), MADV_SEQUENTIAL);
+
+    m_data = static_cast<const uint8_t*> (data);
+    m_size = size_t (info.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data != nullptr)
+        munmap (const_cast<uint8_t*> (m_data), m_size);
+    if (m_fd >= 0)
+        ::close (m_fd);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_fd = -1;
+}
+
+#endif
+
+NpyArray::NpyArray()
+    : m_values(nullptr),
+      m_count(0),
+      m_itemSize(0),
+      m_type(INT64)
+{
+}
+
+bool NpyArray::open (const std::string& path, std::string& error)
+{
+    if (!m_file.open (path))
+    {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    const uint8_t* data = m_file.getData();
+    const size_t size = m_file.getSize();
+
+    if (size < 10 || memcmp (data, "\x93NUMPY", 6) != 0)
+    {
+        error = path + " is not a .npy file";
+        return false;
+    }
+
+    // version 1 has a 2-byte header length, versions 2 and 3 a 4-byte one
+    size_t headerStart;
+    size_t headerLength;
+    if (data[6] == 1)
+    {
+        headerStart = 10;
+        headerLength = size_t (data[8]) | (size_t (data[9]) << 8);
+    }
+    else
+    {
+        headerStart = 12;
+        if (size < headerStart)
+        {
+            error = path + " is truncated";
+            return false;
+        }
+        headerLength = size_t (data[8]) | (size_t (data[9]) << 8) | (size_t (data[10]) << 16) | (size_t (data[11]) << 24);
+    }
+
+    if (headerStart + headerLength > size)
+    {
+        error = path + " is truncated";
+        return false;
+    }
+
+    const std::string header (reinterpret_cast<const char*> (data + headerStart), headerLength);
+
+    const size_t descr = header.find ("'descr'");
+    const size_t quote = header.find ('\'', header.find (':', descr));
+    const std::string dtype = (descr == std::string::npos || quote == std::string::npos)
+                              ? std::string() : header.substr (quote + 1, header.find ('\'', quote + 1) - quote - 1);
+
+    static const struct { const char* name; Type type; size_t size; } types[] =
+    {
+        { "|i1", INT8, 1 }, { "|u1", UINT8, 1 }, { "<i2", INT16, 2 }, { "<u2", UINT16, 2 },
+        { "<i4", INT32, 4 }, { "<u4", UINT32, 4 }, { "<i8", INT64, 8 }, { "<u8", UINT64, 8 }
+    };
+
+    bool known = false;
+    for (const auto& t : types)
+    {
+        if (dtype == t.name)
+        {
+            m_type = t.type;
+            m_itemSize = t.size;
+            known = true;
+        }
+    }
+
+    if (!known)
+    {
+        error = path + ": unsupported dtype '" + dtype + "'";
+        return false;
+    }
+
+    if (header.find ("'fortran_order': True") != std::string::npos)
+    {
+        error = path + ": fortran order is not supported";
+        return false;
+    }
+
+    m_values = data + headerStart + headerLength;
+    m_count = (size - headerStart - headerLength) / m_itemSize;
+    return true;
+}
+
+bool RecordedEvents::open (const std::string& folder, std::string& error)
+{
+    if (!m_timestamps.open (folder + "/timestamps.npy", error)
+        || !m_channels.open (folder + "/channels.npy", error)
+        || !m_states.open (folder + "/channel_states.npy", error))
+        return false;
+
+    if (m_channels.size() != m_timestamps.size() || m_states.size() != m_timestamps.size())
+    {
+        error = folder + ": timestamps, channels and channel_states have different lengths";
+        return false;
+    }
+    return true;
+}
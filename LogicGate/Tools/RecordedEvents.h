@@ -0,0 +1,119 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __RECORDEDEVENTS_H_0B7E93C2__
+#define __RECORDEDEVENTS_H_0B7E93C2__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+    Read-only memory mapping of a whole file.
+*/
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open (const std::string& path);
+    void close();
+
+    const uint8_t* getData() const { return m_data; }
+    size_t getSize() const { return m_size; }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_fd;
+#endif
+
+    MappedFile (const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+};
+
+/**
+    One-dimensional little-endian integer .npy array, read in place from a mapping.
+*/
+class NpyArray
+{
+public:
+    NpyArray();
+
+    /** Maps path and parses its header, error describes what went wrong. */
+    bool open (const std::string& path, std::string& error);
+
+    size_t size() const { return m_count; }
+
+    int64_t operator[] (size_t i) const
+    {
+        const uint8_t* p = m_values + i * m_itemSize;
+        switch (m_type)
+        {
+        case INT8:   return *reinterpret_cast<const int8_t*> (p);
+        case UINT8:  return *p;
+        case INT16:  return *reinterpret_cast<const int16_t*> (p);
+        case UINT16: return *reinterpret_cast<const uint16_t*> (p);
+        case INT32:  return *reinterpret_cast<const int32_t*> (p);
+        case UINT32: return *reinterpret_cast<const uint32_t*> (p);
+        default:     return *reinterpret_cast<const int64_t*> (p);
+        }
+    }
+
+private:
+    enum Type { INT8, UINT8, INT16, UINT16, INT32, UINT32, INT64, UINT64 };
+
+    MappedFile m_file;
+    const uint8_t* m_values;
+    size_t m_count;
+    size_t m_itemSize;
+    Type m_type;
+};
+
+/**
+    TTL events of one Open Ephys binary-format event folder
+    (timestamps.npy, channels.npy and channel_states.npy), memory mapped.
+    Channels are 1-based as in the files, states are +channel on a rising
+    edge and -channel on a falling one.
+*/
+class RecordedEvents
+{
+public:
+    bool open (const std::string& folder, std::string& error);
+
+    size_t size() const { return m_timestamps.size(); }
+    int64_t getTimestamp (size_t i) const { return m_timestamps[i]; }
+    int getChannel (size_t i) const { return int (m_channels[i]); }
+    bool isRising (size_t i) const { return m_states[i] > 0; }
+
+private:
+    NpyArray m_timestamps;
+    NpyArray m_channels;
+    NpyArray m_states;
+};
+
+#endif  // __RECORDEDEVENTS_H_0B7E93C2__
@@ -0,0 +1,378 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+    Streams a recorded TTL event folder through GateEngine, the decision logic
+    of LogicGate::process, and prints the trigger timestamps the plugin would
+    have produced (one per line, in samples).
+
+    With --sweep, the same recording is run through every combination of the
+    listed operators, windows, durations, gate flags and immediate modes on a
+    work-stealing thread pool, and each combination is scored against the
+    rising edges of a target line.
+*/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GateEngine.h"
+#include "RecordedEvents.h"
+#include "Sweep.h"
+#include "WorkStealingPool.h"
+
+static void printUsage (const char* name)
+{
+    fprintf (stderr,
+             "usage: %s <event folder> --rate <Hz> --a <TTL line> [--b <TTL line>]\n"
+             "          [--op AND|OR|XOR|DELAY] [--window <ms>] [--duration <ms>]\n"
+             "          [--gate-a] [--gate-b] [--immediate] [--edges]\n"
+             "       %s <event folder> --sweep --rate <Hz> --a <TTL line> [--b <TTL line>]\n"
+             "          [--op <list>] [--window <list>] [--duration <list>]\n"
+             "          [--gates none,a,b,ab] [--immediate-modes off,on]\n"
+             "          [--target <TTL line>] [--tolerance <ms>] [--threads <n>] [--csv]\n"
+             "\n"
+             "<event folder> holds timestamps.npy, channels.npy and channel_states.npy.\n"
+             "TTL lines are numbered from 1, as in the plugin's input lists.\n"
+             "Prints the rising edge timestamp of every trigger, or every output\n"
+             "edge as timestamp,state with --edges.\n"
+             "\n"
+             "--sweep prints one row per combination: triggers, hit rate (targets with\n"
+             "a trigger within the tolerance) and false alarm rate (triggers with no\n"
+             "target within the tolerance). Lists are comma separated, windows and\n"
+             "durations also take first:last:step ranges.\n", name, name);
+}
+
+static int parseOperator (const char* name)
+{
+    static const char* const names[] = { "AND", "OR", "XOR", "DELAY" };
+    for (int op = LOGIC_AND; op <= LOGIC_DELAY; op++)
+        if (strcmp (name, names[op]) == 0)
+            return op;
+    return -1;
+}
+
+/** Reads "10,20,50" or "10:100:10" (inclusive), appending to values. */
+static bool parseIntList (const char* text, std::vector<int>& values)
+{
+    int first, last, step;
+    char tail;
+    if (sscanf (text, "%d:%d:%d%c", &first, &last, &step, &tail) == 3)
+    {
+        if (step <= 0 || first < 0 || last < first)
+            return false;
+        for (int v = first; v <= last; v += step)
+            values.push_back (v);
+        return true;
+    }
+
+    std::string item;
+    for (const char* c = text; ; c++)
+    {
+        if (*c == ',' || *c == 0)
+        {
+            char* end = nullptr;
+            const long v = strtol (item.c_str(), &end, 10);
+            if (item.empty() || *end != 0 || v < 0)
+                return false;
+            values.push_back (int (v));
+            item.clear();
+            if (*c == 0)
+                return true;
+        }
+        else
+            item += *c;
+    }
+}
+
+/** Calls onItem for every comma separated item of text, stops at the first it rejects. */
+template <typename Callback>
+static bool forEachItem (const char* text, Callback&& onItem)
+{
+    std::string item;
+    for (const char* c = text; ; c++)
+    {
+        if (*c == ',' || *c == 0)
+        {
+            if (!onItem (item))
+                return false;
+            item.clear();
+            if (*c == 0)
+                return true;
+        }
+        else
+            item += *c;
+    }
+}
+
+/** Prints the engine's output as it comes. */
+class OutputPrinter : public GateEngine::Listener
+{
+public:
+    explicit OutputPrinter (bool allEdges)
+        : m_allEdges(allEdges),
+          m_triggers(0)
+    {
+    }
+
+    void gateOutput (int64_t timestamp, bool on, int) override
+    {
+        if (on)
+            ++m_triggers;
+
+        if (m_allEdges)
+            printf ("%" PRId64 ",%d\n", timestamp, on ? 1 : 0);
+        else if (on)
+            printf ("%" PRId64 "\n", timestamp);
+    }
+
+    uint64_t getTriggers() const { return m_triggers; }
+
+private:
+    bool m_allEdges;
+    uint64_t m_triggers;
+};
+
+struct SweepOptions
+{
+    std::vector<int> ops;
+    std::vector<int> windows;
+    std::vector<int> durations;
+    /** Bit 0 gates input A, bit 1 gates input B. */
+    std::vector<int> gates;
+    std::vector<int> immediateModes;
+    int lineTarget = 0;
+    int tolerance = 5;
+    int threads = 0;
+    bool csv = false;
+};
+
+static int runSweep (const RecordedEvents& recording, float sampleRate, int lineA, int lineB, SweepOptions& options)
+{
+    const auto started = std::chrono::steady_clock::now();
+
+    SweepEvents events;
+    SweepEvents::extract (recording, lineA, lineB, options.lineTarget, events);
+
+    if (options.ops.empty())
+        options.ops.push_back (LOGIC_AND);
+    if (options.windows.empty())
+        options.windows.push_back (50);
+    if (options.durations.empty())
+        options.durations.push_back (2);
+    if (options.gates.empty())
+        options.gates.push_back (0);
+    if (options.immediateModes.empty())
+        options.immediateModes.push_back (0);
+
+    std::vector<SweepConfig> configs;
+    for (int op : options.ops)
+        for (int window : options.windows)
+            for (int duration : options.durations)
+                for (int gates : options.gates)
+                    for (int immediate : options.immediateModes)
+                    {
+                        // only OR and XOR have an immediate mode
+                        if (immediate && op != LOGIC_OR && op != LOGIC_XOR)
+                            continue;
+                        SweepConfig config;
+                        config.logicOp = op;
+                        config.window = window;
+                        config.duration = duration;
+                        config.gate1 = (gates & 1) != 0;
+                        config.gate2 = (gates & 2) != 0;
+                        config.immediate = immediate != 0;
+                        configs.push_back (config);
+                    }
+
+    std::vector<SweepResult> results (configs.size());
+    const int64_t tolerance = GateEngine::msToSamples (options.tolerance, sampleRate);
+
+    WorkStealingPool pool (options.threads);
+    pool.parallelFor (configs.size(), [&] (size_t i)
+    {
+        results[i] = evaluateSweepConfig (events, configs[i], sampleRate, tolerance);
+    });
+
+    printSweepTable (stdout, configs, results, events.targets.size(), options.csv);
+
+    const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - started).count();
+    fprintf (stderr, "%zu input edges, %zu targets, %zu configurations on %d threads (%.3f s)\n",
+             events.timestamps.size(), events.targets.size(), configs.size(), pool.getNumThreads(), seconds);
+    return 0;
+}
+
+int main (int argc, char* argv[])
+{
+    const char* folder = nullptr;
+    float sampleRate = 0;
+    int lineA = 0;
+    int lineB = 0;
+    const char* opArg = "AND";
+    const char* windowArg = "50";
+    const char* durationArg = "2";
+    bool allEdges = false;
+    bool sweep = false;
+    bool valid = true;
+    GateConfig config;
+    SweepOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp (argv[i], "--rate") == 0 && hasValue)
+            sampleRate = float (atof (argv[++i]));
+        else if (strcmp (argv[i], "--a") == 0 && hasValue)
+            lineA = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--b") == 0 && hasValue)
+            lineB = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--op") == 0 && hasValue)
+            opArg = argv[++i];
+        else if (strcmp (argv[i], "--window") == 0 && hasValue)
+            windowArg = argv[++i];
+        else if (strcmp (argv[i], "--duration") == 0 && hasValue)
+            durationArg = argv[++i];
+        else if (strcmp (argv[i], "--gate-a") == 0)
+            config.gate1 = true;
+        else if (strcmp (argv[i], "--gate-b") == 0)
+            config.gate2 = true;
+        else if (strcmp (argv[i], "--immediate") == 0)
+            config.immediate = true;
+        else if (strcmp (argv[i], "--edges") == 0)
+            allEdges = true;
+        else if (strcmp (argv[i], "--sweep") == 0)
+            sweep = true;
+        else if (strcmp (argv[i], "--gates") == 0 && hasValue)
+            valid &= forEachItem (argv[++i], [&] (const std::string& item)
+            {
+                static const char* const names[] = { "none", "a", "b", "ab" };
+                for (int g = 0; g < 4; g++)
+                    if (item == names[g])
+                    {
+                        options.gates.push_back (g);
+                        return true;
+                    }
+                return false;
+            });
+        else if (strcmp (argv[i], "--immediate-modes") == 0 && hasValue)
+            valid &= forEachItem (argv[++i], [&] (const std::string& item)
+            {
+                if (item != "off" && item != "on")
+                    return false;
+                options.immediateModes.push_back (item == "on" ? 1 : 0);
+                return true;
+            });
+        else if (strcmp (argv[i], "--target") == 0 && hasValue)
+            options.lineTarget = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--tolerance") == 0 && hasValue)
+            options.tolerance = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--threads") == 0 && hasValue)
+            options.threads = atoi (argv[++i]);
+        else if (strcmp (argv[i], "--csv") == 0)
+            options.csv = true;
+        else if (argv[i][0] != '-' && folder == nullptr)
+            folder = argv[i];
+        else
+            valid = false;
+    }
+
+    int window = 0;
+    int duration = 0;
+    if (sweep)
+    {
+        valid &= forEachItem (opArg, [&] (const std::string& item)
+        {
+            const int op = parseOperator (item.c_str());
+            options.ops.push_back (op);
+            return op >= 0;
+        });
+        valid &= parseIntList (windowArg, options.windows);
+        valid &= parseIntList (durationArg, options.durations);
+        valid &= options.tolerance >= 0;
+    }
+    else
+    {
+        config.logicOp = parseOperator (opArg);
+        window = atoi (windowArg);
+        duration = atoi (durationArg);
+        valid &= config.logicOp >= 0 && window >= 0 && duration >= 0;
+    }
+
+    if (!valid || folder == nullptr || sampleRate <= 0 || lineA <= 0)
+    {
+        printUsage (argv[0]);
+        return 1;
+    }
+
+    RecordedEvents events;
+    std::string error;
+    if (!events.open (folder, error))
+    {
+        fprintf (stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    if (sweep)
+        return runSweep (events, sampleRate, lineA, lineB, options);
+
+    const auto started = std::chrono::steady_clock::now();
+
+    config.windowSamples = GateEngine::msToSamples (window, sampleRate);
+    config.durationSamples = GateEngine::msToSamples (duration, sampleRate);
+
+    OutputPrinter printer (allEdges);
+    GateEngine engine (printer);
+    engine.setConfig (config);
+
+    const size_t n = events.size();
+    if (n > 0)
+        engine.reset (events.getTimestamp (0));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!events.isRising (i))
+            continue;
+
+        const int64_t timestamp = events.getTimestamp (i);
+        const int line = events.getChannel (i);
+        if (line == lineA)
+            engine.inputEdge (0, timestamp);
+        if (line == lineB)
+            engine.inputEdge (1, timestamp);
+    }
+
+    // let the pending windows, delays and pulses play out
+    if (n > 0)
+        engine.advanceTo (events.getTimestamp (n - 1) + config.windowSamples + config.durationSamples + 1);
+
+    const double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - started).count();
+    const ActivityCounters& activity = engine.getActivity();
+    fprintf (stderr, "%zu events, A %" PRIu64 ", B %" PRIu64 ", %" PRIu64 " triggers, %" PRIu64 " expired, %" PRIu64 " dropped (%.3f s)\n",
+             n, ActivityCounters::read (activity.inputEvents[0]), ActivityCounters::read (activity.inputEvents[1]),
+             printer.getTriggers(), ActivityCounters::read (activity.expiredWindows),
+             ActivityCounters::read (activity.drops) + engine.getDelayLine().getOverflowCount(), seconds);
+    return 0;
+}
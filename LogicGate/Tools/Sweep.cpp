@@ -0,0 +1,165 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Sweep.h"
+
+#include <cinttypes>
+
+void SweepEvents::extract (const RecordedEvents& events, int lineA, int lineB, int lineTarget, SweepEvents& result)
+{
+    result.timestamps.clear();
+    result.inputs.clear();
+    result.targets.clear();
+
+    const size_t n = events.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!events.isRising (i))
+            continue;
+
+        const int line = events.getChannel (i);
+        const uint8_t inputs = uint8_t ((line == lineA ? INPUT_A : 0) | (line == lineB ? INPUT_B : 0));
+        if (inputs != 0)
+        {
+            result.timestamps.push_back (events.getTimestamp (i));
+            result.inputs.push_back (inputs);
+        }
+        if (lineTarget > 0 && line == lineTarget)
+            result.targets.push_back (events.getTimestamp (i));
+    }
+}
+
+/** Keeps the rising edge of every trigger. */
+class TriggerCollector : public GateEngine::Listener
+{
+public:
+    explicit TriggerCollector (std::vector<int64_t>& triggers)
+        : m_triggers(triggers)
+    {
+    }
+
+    void gateOutput (int64_t timestamp, bool on, int) override
+    {
+        if (on)
+            m_triggers.push_back (timestamp);
+    }
+
+private:
+    std::vector<int64_t>& m_triggers;
+};
+
+SweepResult evaluateSweepConfig (const SweepEvents& events, const SweepConfig& config,
+                                 float sampleRate, int64_t toleranceSamples)
+{
+    GateConfig gate;
+    gate.logicOp = config.logicOp;
+    gate.gate1 = config.gate1;
+    gate.gate2 = config.gate2;
+    gate.immediate = config.immediate;
+    gate.windowSamples = GateEngine::msToSamples (config.window, sampleRate);
+    gate.durationSamples = GateEngine::msToSamples (config.duration, sampleRate);
+
+    std::vector<int64_t> triggers;
+    TriggerCollector collector (triggers);
+    GateEngine engine (collector);
+    engine.setConfig (gate);
+
+    const size_t n = events.timestamps.size();
+    if (n > 0)
+        engine.reset (events.timestamps[0]);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (events.inputs[i] & SweepEvents::INPUT_A)
+            engine.inputEdge (0, events.timestamps[i]);
+        if (events.inputs[i] & SweepEvents::INPUT_B)
+            engine.inputEdge (1, events.timestamps[i]);
+    }
+
+    if (n > 0)
+        engine.advanceTo (events.timestamps[n - 1] + gate.windowSamples + gate.durationSamples + 1);
+
+    SweepResult result;
+    result.triggers = triggers.size();
+
+    // both lists are sorted: walk them together
+    const std::vector<int64_t>& targets = events.targets;
+    size_t t = 0;
+    for (size_t i = 0; i < triggers.size(); i++)
+    {
+        while (t < targets.size() && targets[t] < triggers[i] - toleranceSamples)
+            ++t;
+        if (t == targets.size() || targets[t] > triggers[i] + toleranceSamples)
+            ++result.falseAlarms;
+    }
+
+    size_t k = 0;
+    for (size_t j = 0; j < targets.size(); j++)
+    {
+        while (k < triggers.size() && triggers[k] < targets[j] - toleranceSamples)
+            ++k;
+        if (k < triggers.size() && triggers[k] <= targets[j] + toleranceSamples)
+            ++result.hits;
+    }
+
+    return result;
+}
+
+static const char* gateName (const SweepConfig& config)
+{
+    if (config.gate1 && config.gate2)
+        return "ab";
+    if (config.gate1)
+        return "a";
+    if (config.gate2)
+        return "b";
+    return "none";
+}
+
+void printSweepTable (FILE* out, const std::vector<SweepConfig>& configs, const std::vector<SweepResult>& results,
+                      size_t numTargets, bool csv)
+{
+    static const char* const opNames[] = { "AND", "OR", "XOR", "DELAY" };
+
+    if (csv)
+        fprintf (out, "op,window_ms,duration_ms,gates,immediate,triggers,hits,hit_rate,false_alarms,fa_rate\n");
+    else
+        fprintf (out, "%-5s %7s %5s %5s %3s %9s %9s %8s %9s %8s\n",
+                 "op", "window", "dur", "gates", "imm", "triggers", "hits", "hit%", "f.alarms", "fa%");
+
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        const SweepConfig& c = configs[i];
+        const SweepResult& r = results[i];
+        const double hitRate = numTargets > 0 ? double (r.hits) / numTargets : 0.0;
+        const double faRate = r.triggers > 0 ? double (r.falseAlarms) / r.triggers : 0.0;
+
+        if (csv)
+            fprintf (out, "%s,%d,%d,%s,%d,%" PRIu64 ",%" PRIu64 ",%.4f,%" PRIu64 ",%.4f\n",
+                     opNames[c.logicOp], c.window, c.duration, gateName (c), c.immediate ? 1 : 0,
+                     r.triggers, r.hits, hitRate, r.falseAlarms, faRate);
+        else
+            fprintf (out, "%-5s %7d %5d %5s %3s %9" PRIu64 " %9" PRIu64 " %8.2f %9" PRIu64 " %8.2f\n",
+                     opNames[c.logicOp], c.window, c.duration, gateName (c), c.immediate ? "y" : "n",
+                     r.triggers, r.hits, 100.0 * hitRate, r.falseAlarms, 100.0 * faRate);
+    }
+}
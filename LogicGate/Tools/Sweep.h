@@ -0,0 +1,88 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __SWEEP_H_4F6B21D3__
+#define __SWEEP_H_4F6B21D3__
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "GateEngine.h"
+#include "RecordedEvents.h"
+
+/**
+ * @brief The SweepEvents struct holds the rising edges a sweep cares about,
+ * extracted once from the recording and then shared read-only by every worker
+ */
+struct SweepEvents
+{
+    enum
+    {
+        INPUT_A = 1,
+        INPUT_B = 2
+    };
+
+    std::vector<int64_t> timestamps;
+    std::vector<uint8_t> inputs;
+    /** Rising edges of the target line, the events the gate is supposed to detect. */
+    std::vector<int64_t> targets;
+
+    /** lineTarget <= 0 means no target line. */
+    static void extract (const RecordedEvents& events, int lineA, int lineB, int lineTarget, SweepEvents& result);
+};
+
+/**
+ * @brief The SweepConfig struct is one point of the sweep, in the units of the editor
+ */
+struct SweepConfig
+{
+    int logicOp;
+    int window;
+    int duration;
+    bool gate1;
+    bool gate2;
+    bool immediate;
+};
+
+struct SweepResult
+{
+    uint64_t triggers = 0;
+    /** Targets with a trigger within the tolerance. */
+    uint64_t hits = 0;
+    /** Triggers with no target within the tolerance. */
+    uint64_t falseAlarms = 0;
+};
+
+/**
+ * @brief evaluateSweepConfig runs one configuration through GateEngine and scores
+ * its triggers against the targets: a trigger and a target match when they are at
+ * most toleranceSamples apart
+ */
+SweepResult evaluateSweepConfig (const SweepEvents& events, const SweepConfig& config,
+                                 float sampleRate, int64_t toleranceSamples);
+
+/** Prints one line per configuration, as an aligned table or as CSV. */
+void printSweepTable (FILE* out, const std::vector<SweepConfig>& configs, const std::vector<SweepResult>& results,
+                      size_t numTargets, bool csv);
+
+#endif  // __SWEEP_H_4F6B21D3__
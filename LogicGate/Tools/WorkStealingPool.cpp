@@ -0,0 +1,144 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool (int numThreads)
+    : m_generation(0),
+      m_quit(false),
+      m_task(nullptr),
+      m_remaining(0),
+      m_active(0)
+{
+    if (numThreads <= 0)
+        numThreads = int (std::thread::hardware_concurrency());
+    if (numThreads <= 0)
+        numThreads = 1;
+
+    for (int i = 0; i < numThreads; i++)
+        m_queues.emplace_back (new Queue());
+    for (int i = 0; i < numThreads; i++)
+        m_workers.emplace_back (&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock (m_lock);
+        m_quit = true;
+    }
+    m_start.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void WorkStealingPool::parallelFor (size_t count, const std::function<void (size_t)>& task)
+{
+    if (count == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock (m_lock);
+
+    // a worker still scanning the queues of the previous batch would run this batch with the old task
+    m_done.wait (lock, [this] { return m_active == 0; });
+
+    const size_t numQueues = m_queues.size();
+    for (size_t q = 0; q < numQueues; q++)
+    {
+        std::lock_guard<std::mutex> queueLock (m_queues[q]->lock);
+        for (size_t i = q * count / numQueues; i < (q + 1) * count / numQueues; i++)
+            m_queues[q]->items.push_back (i);
+    }
+
+    m_task = &task;
+    m_remaining.store (count);
+    ++m_generation;
+    m_start.notify_all();
+
+    m_done.wait (lock, [this] { return m_remaining.load() == 0; });
+    m_task = nullptr;
+}
+
+void WorkStealingPool::run (int self)
+{
+    uint64_t seen = 0;
+
+    for (;;)
+    {
+        const std::function<void (size_t)>* task;
+        {
+            std::unique_lock<std::mutex> lock (m_lock);
+            m_start.wait (lock, [this, seen] { return m_quit || m_generation != seen; });
+            if (m_quit)
+                return;
+            seen = m_generation;
+            task = m_task;
+            ++m_active;
+        }
+
+        size_t item;
+        while (popLocal (self, item) || steal (self, item))
+        {
+            (*task) (item);
+
+            if (m_remaining.fetch_sub (1) == 1)
+            {
+                std::lock_guard<std::mutex> lock (m_lock);
+                m_done.notify_all();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock (m_lock);
+        if (--m_active == 0)
+            m_done.notify_all();
+    }
+}
+
+bool WorkStealingPool::popLocal (int self, size_t& item)
+{
+    Queue& queue = *m_queues[self];
+    std::lock_guard<std::mutex> lock (queue.lock);
+    if (queue.items.empty())
+        return false;
+
+    item = queue.items.back();
+    queue.items.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal (int self, size_t& item)
+{
+    const int numQueues = int (m_queues.size());
+    for (int offset = 1; offset < numQueues; offset++)
+    {
+        Queue& victim = *m_queues[(self + offset) % numQueues];
+        std::lock_guard<std::mutex> lock (victim.lock);
+        if (!victim.items.empty())
+        {
+            item = victim.items.front();
+            victim.items.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
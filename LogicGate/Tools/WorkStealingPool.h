@@ -0,0 +1,84 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2016 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __WORKSTEALINGPOOL_H_92A4D7E1__
+#define __WORKSTEALINGPOOL_H_92A4D7E1__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+    Fixed set of worker threads, each with its own task deque.
+
+    parallelFor() deals the indices out in contiguous blocks, one per worker.
+    A worker takes from the back of its own deque and, once it runs dry,
+    steals from the front of the others, so uneven tasks still keep every
+    core busy until the end.
+*/
+class WorkStealingPool
+{
+public:
+    /** numThreads <= 0 uses every hardware thread. */
+    explicit WorkStealingPool (int numThreads = 0);
+    ~WorkStealingPool();
+
+    int getNumThreads() const { return int (m_workers.size()); }
+
+    /** Runs task(i) for every i in [0, count) and returns once all of them are done. */
+    void parallelFor (size_t count, const std::function<void (size_t)>& task);
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    void run (int self);
+    bool popLocal (int self, size_t& item);
+    bool steal (int self, size_t& item);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_lock;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation;
+    bool m_quit;
+
+    const std::function<void (size_t)>* m_task;
+    std::atomic<size_t> m_remaining;
+    int m_active;
+
+    WorkStealingPool (const WorkStealingPool&) = delete;
+    WorkStealingPool& operator= (const WorkStealingPool&) = delete;
+};
+
+#endif  // __WORKSTEALINGPOOL_H_92A4D7E1__